@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <ctype.h>
 #include <sstream>
 #include <memory>
 
@@ -83,9 +84,9 @@ namespace {
     const std::string keywordEnum("enum");
     const std::string keywordThis("this");
     const std::string keywordExplicit("explicit");
-    const std::string keywordThreadLocal("thread_local");
     const std::string keywordStaticCast("static_cast");
     const std::string keywordGoto("goto");
+    const std::string keywordConst("const");
 
     const std::string null("nullptr");
     const std::string ifNotDef("#ifndef ");
@@ -100,7 +101,12 @@ namespace {
     const std::string objectName("object");
     const std::string dynamicPointerCastName("dynamicPointerCast");
     const std::string staticPointerCastName("staticPointerCast");
+    const std::string moveName("std::move");
     const std::string arrayAtName("at");
+    const std::string arrayUncheckedAtName("uncheckedAt");
+    const std::string processLocalClassName("ProcessLocal");
+    const std::string processLocalGetName("get()");
+    const std::string stackObjectSuffix("_Object");
 
     void replace(Identifier& value, const Identifier& what, char with) {
         while (true) {
@@ -125,6 +131,77 @@ namespace {
         return mangledSymbol;
     }
 
+    // Static data members are private to each process. Except for constants
+    // of primitive type, they are stored in process local storage.
+    bool isProcessLocal(const DataMemberDefinition* dataMember) {
+        const Type* type = dataMember->getType();
+        return dataMember->isStatic() &&
+               !(type->isConstant() && type->isPrimitive());
+    }
+
+    // Arguments of reference type that the method does not assign or take
+    // over are passed as const references, which saves updating the
+    // reference count on every call.
+    bool isPassedByReference(const VariableDeclaration* argument) {
+        const Type* type = argument->getType();
+        return type->isReference() && type->isConstant() &&
+               !argument->isPassedByValue();
+    }
+
+    // Whether the expression refers to a data member or an array element,
+    // rather than to a local variable or a temporary.
+    bool isStoredInHeap(const Expression* expression) {
+        switch (expression->getKind()) {
+            case Expression::MemberSelector:
+                return isStoredInHeap(
+                    expression->cast<MemberSelectorExpression>()->getRight());
+            case Expression::Member:
+                if (expression->cast<MemberExpression>()->getKind() !=
+                    MemberExpression::DataMember) {
+                    return false;
+                }
+                break;
+            case Expression::ArraySubscript:
+                break;
+            default:
+                return false;
+        }
+        const Type* type = expression->getType();
+        return type != nullptr && type->isReference();
+    }
+
+    // The characters of a string that is created from a string literal, or
+    // from another array literal of character literals, or null if the
+    // string is created in some other way.
+    const ArrayLiteralExpression* getStringLiteralCharacters(
+        const HeapAllocationExpression* allocExpression) {
+
+        const Type* type = allocExpression->getType();
+        if (!type->isString() || type->isArray()) {
+            return nullptr;
+        }
+        const ExpressionList& arguments =
+            allocExpression->getConstructorCall()->getArguments();
+        if (arguments.size() != 1 ||
+            arguments.front()->getKind() != Expression::ArrayAllocation) {
+            return nullptr;
+        }
+        const ArrayLiteralExpression* arrayLiteral =
+            arguments.front()->cast<ArrayAllocationExpression>()->
+                getInitExpression();
+        if (arrayLiteral == nullptr) {
+            return nullptr;
+        }
+        for (auto element: arrayLiteral->getElements()) {
+            if (element->getKind() != Expression::Literal ||
+                element->cast<LiteralExpression>()->getKind() !=
+                    LiteralExpression::Character) {
+                return nullptr;
+            }
+        }
+        return arrayLiteral;
+    }
+
     Identifier eraseInitFromConstructorName(const Identifier& name) {
         Identifier retval(name);
         Identifier toBeErased("_" + Keyword::initString);
@@ -268,6 +345,59 @@ void CppBackEnd::generateClass(const ClassDefinition* classDef) {
     generateCpp(closeBrace);
     generateSemicolonAndNewline();
     generateNewline();
+
+    generateTypeRegistration(classDef);
+}
+
+// Generate the registration of the deserializer of a message class, so that
+// ByteBuffer::readObject() can create objects of the class from the type tag
+// written by the _serialize() method:
+//
+// static const bool ClassName_registered =
+//     ByteBuffer::registerType(
+//         [TypeTag],
+//         "ClassName",
+//         [] (const Pointer<ByteBuffer>& buffer) -> Pointer<object> {
+//             return new ClassName(buffer);
+//         });
+//
+void CppBackEnd::generateTypeRegistration(const ClassDefinition* classDef) {
+    if (!classDef->isMessage() || classDef->isEnumeration() ||
+        classDef->isInterface() ||
+        classDef->getDeserializingConstructor() == nullptr) {
+        return;
+    }
+
+    setImplementationMode();
+    std::ostringstream tag;
+    tag << Symbol::makeTypeTag(classDef->getName());
+
+    generateCpp("static const bool ");
+    generateCpp(mangle(classDef->getName()) + "_registered =");
+    increaseIndent();
+    generateNewline();
+    generateCpp("ByteBuffer::registerType(");
+    increaseIndent();
+    generateNewline();
+    generateCpp(tag.str() + ",");
+    generateNewline();
+    generateCpp(quote + classDef->getName() + quote + ",");
+    generateNewline();
+    generateCpp("[] (const Pointer<ByteBuffer>& buffer) -> Pointer<object> {");
+    increaseIndent();
+    generateNewline();
+    generateCpp("return new ");
+    generateScope(classDef->getEnclosingDefinition());
+    generateCpp(mangle(classDef->getName()) + "(buffer)");
+    generateSemicolonAndNewline();
+    decreaseIndent();
+    eraseLastChars(indentSize);
+    generateCpp("})");
+    decreaseIndent();
+    decreaseIndent();
+    generateSemicolonAndNewline();
+    generateNewline();
+    setHeaderMode();
 }
 
 void CppBackEnd::generateClassParentList(const ClassDefinition* classDef) {
@@ -448,7 +578,16 @@ void CppBackEnd::generateArgumentList(const ArgumentList& arguments) {
             break;
         }
 
-        generateType(type); 
+        if (isPassedByReference(argument)) {
+            generateCpp(keywordConst);
+            generateCpp(space);
+            generateType(type);
+            eraseLastChars(1);
+            generateCpp(operatorBitwiseAnd);
+            generateCpp(space);
+        } else {
+            generateType(type);
+        }
         generateCpp(mangle(argument->getIdentifier()));
         if (++i != arguments.end()) {
             generateCpp(comma);
@@ -463,38 +602,54 @@ void CppBackEnd::generateDataMember(const DataMemberDefinition* dataMember) {
     if (dataMember->isStatic()) {
         generateCpp(keywordStatic);
         generateCpp(space);
-        generateThreadLocal(dataMember->getType());
     }
 
     const Type* type = dataMember->getType();
     assert(type);
-    generateType(type);
+    if (isProcessLocal(dataMember)) {
+        generateProcessLocalType(type);
+    } else {
+        generateType(type);
+    }
     generateCpp(mangle(dataMember->getName()));
     generateSemicolonAndNewline();
     if (dataMember->isStatic()) {
         setImplementationMode();
-        generateThreadLocal(dataMember->getType());
-        generateType(type);
-        generateScope(dataMember->getEnclosingDefinition());
-        generateCpp(mangle(dataMember->getName()));
-
         Expression* init = dataMember->getExpression();
-        if (init) {
-            generateCpp(space);
-            generateCpp(operatorAssignment);
-            generateCpp(space);
-            generateExpression(init);
+        if (isProcessLocal(dataMember)) {
+            // The initializer is evaluated lazily the first time each process
+            // accesses the data member.
+            generateProcessLocalType(type);
+            generateScope(dataMember->getEnclosingDefinition());
+            generateCpp(mangle(dataMember->getName()));
+            if (init) {
+                generateCpp("([]() -> ");
+                generateType(type);
+                generateCpp("{ return ");
+                generateExpression(init);
+                generateCpp("; })");
+            }
+        } else {
+            generateType(type);
+            generateScope(dataMember->getEnclosingDefinition());
+            generateCpp(mangle(dataMember->getName()));
+            if (init) {
+                generateCpp(space);
+                generateCpp(operatorAssignment);
+                generateCpp(space);
+                generateExpression(init);
+            }
         }
         generateSemicolonAndNewline();
         setHeaderMode();
     }
 }
 
-void CppBackEnd::generateThreadLocal(const Type* type) {
-    if (type->isConstant() && type->isPrimitive()) {
-        return;
-    }
-    generateCpp(keywordThreadLocal);
+void CppBackEnd::generateProcessLocalType(const Type* type) {
+    generateCpp(processLocalClassName);
+    generateCpp(operatorLess);
+    generateType(type);
+    generateCpp(operatorGreater);
     generateCpp(space);
 }
 
@@ -565,6 +720,11 @@ void CppBackEnd::generateStatement(const Statement* statement) {
 void CppBackEnd::generateVariableDeclaration(
     const VariableDeclarationStatement* varDecl) {
 
+    if (varDecl->isStackAllocated()) {
+        generateStackAllocatedVariableDeclaration(varDecl);
+        return;
+    }
+
     generateType(varDecl->getType()); 
     generateCpp(mangle(varDecl->getIdentifier()));
 
@@ -578,6 +738,45 @@ void CppBackEnd::generateVariableDeclaration(
     generateSemicolonAndNewline();
 }
 
+//
+// let a = new A(1)
+// C++, when the object does not outlive the method:
+// A a_Object(1);
+// A* a = &a_Object;
+//
+void CppBackEnd::generateStackAllocatedVariableDeclaration(
+    const VariableDeclarationStatement* varDecl) {
+
+    auto allocation =
+        varDecl->getInitExpression()->cast<HeapAllocationExpression>();
+    const Type* type = allocation->getType();
+    Identifier name(mangle(varDecl->getIdentifier()));
+    Identifier objectName(name + stackObjectSuffix);
+
+    generateTypeName(type);
+    generateCpp(space);
+    generateCpp(objectName);
+    const ExpressionList& arguments =
+        allocation->getConstructorCall()->getArguments();
+    if (auto characters = getStringLiteralCharacters(allocation)) {
+        generateStringLiteralArguments(characters);
+    } else if (!arguments.empty()) {
+        generateMethodCallArguments(arguments);
+    }
+    generateSemicolonAndNewline();
+
+    generateTypeName(type);
+    generateCpp(operatorMultiplication);
+    generateCpp(space);
+    generateCpp(name);
+    generateCpp(space);
+    generateCpp(operatorAssignment);
+    generateCpp(space);
+    generateCpp(operatorBitwiseAnd);
+    generateCpp(objectName);
+    generateSemicolonAndNewline();
+}
+
 //
 // A a = new A()
 // C++:
@@ -934,10 +1133,74 @@ void CppBackEnd::generateHeapAllocationExpression(
     generateCpp(openParentheses);
     generateCpp(keywordNew);
     generateCpp(space);
-    generateMethodCall(allocExpression->getConstructorCall());
+    if (auto characters = getStringLiteralCharacters(allocExpression)) {
+        generateCpp(stringName);
+        generateStringLiteralArguments(characters);
+    } else {
+        generateMethodCall(allocExpression->getConstructorCall());
+    }
     generateCpp(closeParentheses);
 }
 
+//
+// new string("a\"b")
+// C++:
+// Pointer<string>(new string("a\"b", 3))
+//
+// The string is created straight from the characters, without first creating
+// a char array.
+//
+void CppBackEnd::generateStringLiteralArguments(
+    const ArrayLiteralExpression* characters) {
+
+    const ExpressionList& elements = characters->getElements();
+    generateCpp(openParentheses);
+    generateCpp(quote);
+    for (auto element: elements) {
+        generateStringChar(
+            element->cast<CharacterLiteralExpression>()->getValue());
+    }
+    generateCpp(quote);
+    generateCpp(comma);
+    generateCpp(space);
+    std::stringstream lengthStr;
+    lengthStr << elements.size();
+    generateCpp(lengthStr.str());
+    generateCpp(closeParentheses);
+}
+
+// Question marks are escaped so that they can not form trigraphs, and
+// characters that are not printable are written as three octal digits so
+// that a digit that follows is not taken as part of the escape sequence.
+void CppBackEnd::generateStringChar(char c) {
+    switch (c) {
+        case '\r':
+            generateCpp(backslash);
+            generateCpp('r');
+            break;
+        case '\n':
+            generateCpp(backslash);
+            generateCpp('n');
+            break;
+        case '"':
+        case '\\':
+        case '?':
+            generateCpp(backslash);
+            generateCpp(c);
+            break;
+        default:
+            if (isprint(static_cast<unsigned char>(c))) {
+                generateCpp(c);
+            } else {
+                char octal[5];
+                snprintf(octal, sizeof octal, "\\%03o",
+                         static_cast<unsigned char>(c));
+                generateCpp(std::string(octal));
+            }
+            break;
+    }
+}
+
 //
 // A[] a = new A[3]
 // C++:
@@ -974,7 +1237,11 @@ void CppBackEnd::generateArraySubscriptExpression(
 
     generateExpression(arraySubscriptExpression->getArrayNameExpression());
     generateCpp(operatorArrow);
-    generateCpp(arrayAtName);
+    if (arraySubscriptExpression->isIndexInBounds()) {
+        generateCpp(arrayUncheckedAtName);
+    } else {
+        generateCpp(arrayAtName);
+    }
     generateCpp(openParentheses);
     generateExpression(arraySubscriptExpression->getIndexExpression());
     generateCpp(closeParentheses);
@@ -1028,6 +1295,10 @@ void CppBackEnd::generateDataMemberExpression(
     const DataMemberExpression* dataMemberExpression) {
 
     generateCpp(mangle(dataMemberExpression->getName()));
+    if (isProcessLocal(dataMemberExpression->getDataMemberDefinition())) {
+        generateCpp(operatorDot);
+        generateCpp(processLocalGetName);
+    }
 }
 
 void CppBackEnd::generateMethodCall(const MethodCallExpression* methodCall) {
@@ -1036,12 +1307,25 @@ void CppBackEnd::generateMethodCall(const MethodCallExpression* methodCall) {
         name = eraseInitFromConstructorName(name);
     }
     generateCpp(mangle(name));
+    generateMethodCallArguments(methodCall->getArguments());
+}
 
+void CppBackEnd::generateMethodCallArguments(const ExpressionList& arguments) {
     generateCpp(openParentheses);
-    const ExpressionList& arguments = methodCall->getArguments();
     for (auto i = arguments.cbegin(); i != arguments.cend(); ) {
         const Expression* argument = *i;
-        generateExpression(argument);
+        if (isStoredInHeap(argument)) {
+            // The argument may be bound to a const reference, and the called
+            // method could replace the data member or array element that it
+            // refers to. Pass a copy so that the object stays alive.
+            generateType(argument->getType());
+            eraseLastChars(1);
+            generateCpp(openParentheses);
+            generateExpression(argument);
+            generateCpp(closeParentheses);
+        } else {
+            generateExpression(argument);
+        }
         if (++i != arguments.end()) {
             generateCpp(comma);
             generateCpp(space);
@@ -1068,6 +1352,15 @@ void CppBackEnd::generateMemberSelectorExpression(
 void CppBackEnd::generateLocalVariableExpression(
     const LocalVariableExpression* localVarExpression) {
 
+    if (localVarExpression->isLastUse() &&
+        localVarExpression->getType()->isReference()) {
+        // The variable is not used after this, so the reference can be moved
+        // instead of copied.
+        generateCpp(moveName + "(");
+        generateCpp(mangle(localVarExpression->getName()));
+        generateCpp(")");
+        return;
+    }
     generateCpp(mangle(localVarExpression->getName()));
 }
 
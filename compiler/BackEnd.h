@@ -35,6 +35,7 @@ private:
     void generateClassParentList(const ClassDefinition* classDef);
     void generateClassParent(const Identifier& parentName);
     void generateVirtualDestructor(const ClassDefinition* classDef);
+    void generateTypeRegistration(const ClassDefinition* classDef);
     void generateClassMembers(const ClassDefinition* classDef);
     void generateClassMember(const ClassMemberDefinition* member);
     void generateMethod(const MethodDefinition* method);
@@ -42,10 +43,12 @@ private:
     void generateScope(const Definition* enclosing);
     void generateArgumentList(const ArgumentList& arguments);
     void generateDataMember(const DataMemberDefinition* dataMember);
-    void generateThreadLocal(const Type* type);
+    void generateProcessLocalType(const Type* type);
     void generateBlock(const BlockStatement* block);
     void generateStatement(const Statement* statement);
     void generateVariableDeclaration(const VariableDeclarationStatement* node);
+    void generateStackAllocatedVariableDeclaration(
+        const VariableDeclarationStatement* varDecl);
     void generateType(const Type* type, bool generatePointer = true);
     void generateArrayType(const Type* type);
     void generateTypeName(const Type* type);
@@ -64,6 +67,9 @@ private:
     void generateExpressionOperator(Operator::Kind op);
     void generateHeapAllocationExpression(
         const HeapAllocationExpression* allocExpression);
+    void generateStringLiteralArguments(
+        const ArrayLiteralExpression* characters);
+    void generateStringChar(char c);
     void generateArrayAllocationExpression(
         const ArrayAllocationExpression* allocExpression);
     void generateArraySubscriptExpression(
@@ -74,6 +80,7 @@ private:
     void generateDataMemberExpression(
         const DataMemberExpression* dataMemberExpression);
     void generateMethodCall(const MethodCallExpression* methodCall);
+    void generateMethodCallArguments(const ExpressionList& arguments);
     void generateMemberSelectorExpression(
         const MemberSelectorExpression* memberAccess);
     void generateLocalVariableExpression(
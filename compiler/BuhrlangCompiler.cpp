@@ -40,7 +40,11 @@ namespace {
         }
     }
 
-    void callGcc(const std::string& executableName) {
+    void callGcc(
+        const std::string& executableName,
+        const std::string& allocator,
+        bool regions) {
+
         std::string objectFiles;
         for (auto module: modules) {
             const std::string& filename = module->getFilename();
@@ -53,6 +57,12 @@ namespace {
                 // because of fdopen().
                 cmd += " -std=c++11";
             }
+            if (allocator == "slab") {
+                cmd += " -DBUHRLANG_SLAB_ALLOCATOR";
+            }
+            if (regions) {
+                cmd += " -DBUHRLANG_REGION_ALLOCATOR";
+            }
             cmd += " -g -c " + filename + ".cpp -o " + filename +
                    ".o -I . -I " + compilerPath + "stdlib/ -I " + compilerPath +
                    "runtime/ -pthread";
@@ -70,16 +80,28 @@ namespace {
 
 int main(int argc, char** argv) {
     std::string executableName;
+    std::string allocator;
+    bool regions = false;
     int c;
     opterr = 0;
 
-    while ((c = getopt(argc, argv, "o:")) != -1) {
+    while ((c = getopt(argc, argv, "o:a:r")) != -1) {
         switch (c) {
             case 'o':
                 executableName = optarg;
                 break;
+            case 'a':
+                allocator = optarg;
+                if (allocator != "slab" && allocator != "malloc") {
+                    printf("Unknown allocator `%s'.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                regions = true;
+                break;
             case '?':
-                if (optopt == 'o') {
+                if (optopt == 'o' || optopt == 'a') {
                     printf("Option -%c requires an argument.\n", optopt);
                 } else if (isprint(optopt)) {
                     printf("Unknown option `-%c'.\n", optopt);
@@ -100,7 +122,7 @@ int main(int argc, char** argv) {
 
     compile();
     writeGeneratedCppCodeToDisk();
-    callGcc(executableName);
+    callGcc(executableName, allocator, regions);
     removeGeneratedCppCode();
 
     return 0;
@@ -7,9 +7,12 @@
 namespace {
     const Identifier elementVariableName("element");
 
-    MethodDefinition* getCloneMethod(const ClassDefinition *classDef) {
+    MethodDefinition* getMethod(
+        const ClassDefinition *classDef,
+        const Identifier& name) {
+
         for (auto method: classDef->getMethods()) {
-            if (method->getName().compare(CommonNames::cloneMethodName) == 0) {
+            if (method->getName().compare(name) == 0) {
                 return method;
             }
         }
@@ -33,7 +36,7 @@ namespace {
     void generateCloneMethod(ClassDefinition* inputClass, Tree& tree) {
         // An empty clone method was created for the message class when the
         // class was created. We will now generate the method body.
-        auto cloneMethod = getCloneMethod(inputClass);
+        auto cloneMethod = getMethod(inputClass, CommonNames::cloneMethodName);
         tree.setCurrentBlock(cloneMethod->getBody());
 
         auto constructorCall =
@@ -320,7 +323,7 @@ namespace {
         generateBaseClassConstructorCall(inputClass, tree);
 
         for (auto dataMember: inputClass->getDataMembers()) {
-            if (dataMember->isStatic()) {
+            if (dataMember->isStatic() || dataMember->isRuntimeOnly()) {
                 continue;
             }
 
@@ -338,6 +341,86 @@ namespace {
 
         tree.finishBlock();
     }
+
+    // Generate the following expression:
+    //
+    // member._isUnique
+    //
+    // Returns null if the uniqueness of the member cannot be checked.
+    Expression* generateMemberIsUniqueCall(
+        const DataMemberDefinition* dataMember,
+        const ClassDefinition* inputClass) {
+
+        const auto dataMemberType = dataMember->getType();
+        if (dataMemberType->isEnumeration() ||
+            (dataMemberType->isArray() &&
+             Type::createArrayElementType(dataMemberType)->isEnumeration())) {
+            // Enums have no _isUnique method.
+            return nullptr;
+        }
+        if (dataMember->isPrivate() &&
+            dataMember->getEnclosingClass() != inputClass) {
+            // Private members of a base class cannot be accessed.
+            return nullptr;
+        }
+        return MemberSelectorExpression::create(
+            NamedEntityExpression::create(dataMember->getName()),
+            MethodCallExpression::create(CommonNames::isUniqueMethodName));
+    }
+
+    // Generate the following method:
+    //
+    // bool _isUnique() {
+    //     return _referenceCount == 1 &&
+    //            complexMember._isUnique &&
+    //            memberArray._isUnique && ...
+    // }
+    //
+    // The data members of the base classes are checked as well. If a member
+    // is of enum type, or is a private member of a base class, then the method
+    // just returns false, which means the object will be cloned when sent.
+    void generateIsUniqueMethod(ClassDefinition* inputClass, Tree& tree) {
+        // An empty _isUnique method was created for the message class when the
+        // class was created. We will now generate the method body.
+        auto isUniqueMethod =
+            getMethod(inputClass, CommonNames::isUniqueMethodName);
+        tree.setCurrentBlock(isUniqueMethod->getBody());
+
+        auto referenceCount =
+            MethodCallExpression::create(
+                BuiltInTypes::objectReferenceCountMethodName);
+        Expression* result =
+            BinaryExpression::create(Operator::Equal,
+                                     referenceCount,
+                                     IntegerLiteralExpression::create(1));
+
+        for (auto classDef = inputClass;
+             classDef != nullptr && classDef->isMessage();
+             classDef = classDef->getBaseClass()) {
+            for (auto dataMember: classDef->getDataMembers()) {
+                if (dataMember->isStatic() ||
+                    dataMember->getType()->isPrimitive()) {
+                    continue;
+                }
+
+                auto isUniqueCall =
+                    generateMemberIsUniqueCall(dataMember, inputClass);
+                if (isUniqueCall == nullptr) {
+                    result = BooleanLiteralExpression::create(false,
+                                                              Location());
+                    tree.addStatement(ReturnStatement::create(result));
+                    tree.finishBlock();
+                    return;
+                }
+                result = BinaryExpression::create(Operator::LogicalAnd,
+                                                  result,
+                                                  isUniqueCall);
+            }
+        }
+
+        tree.addStatement(ReturnStatement::create(result));
+        tree.finishBlock();
+    }
 }
 
 void CloneGenerator::generate(ClassDefinition* inputClass, Tree& tree) {
@@ -345,13 +428,15 @@ void CloneGenerator::generate(ClassDefinition* inputClass, Tree& tree) {
 
     generateCopyConstructor(inputClass, tree);
     generateCloneMethod(inputClass, tree);
+    generateIsUniqueMethod(inputClass, tree);
 
     tree.finishClass();
 }
 
-// Generate the following method:
+// Generate the following methods:
 //
 // object _clone() {}
+// bool _isUnique() {}
 //
 void CloneGenerator::generateEmptyCloneMethod(ClassDefinition *classDef) {
     auto cloneMethod =
@@ -360,4 +445,11 @@ void CloneGenerator::generateEmptyCloneMethod(ClassDefinition *classDef) {
                                  false,
                                  classDef);
     classDef->appendMember(cloneMethod);
+
+    auto isUniqueMethod =
+        MethodDefinition::create(CommonNames::isUniqueMethodName,
+                                 Type::create(Type::Boolean),
+                                 false,
+                                 classDef);
+    classDef->appendMember(isUniqueMethod);
 }
@@ -54,6 +54,8 @@ const std::string Keyword::jumpString("__jump");
 
 const std::string BuiltInTypes::objectEqualsMethodName("equals");
 const std::string BuiltInTypes::objectHashMethodName("hash");
+const std::string BuiltInTypes::objectReferenceCountMethodName(
+    "_referenceCount");
 const std::string BuiltInTypes::arrayTypeName("array");
 const std::string BuiltInTypes::arrayEachMethodName("each");
 const std::string BuiltInTypes::arrayLengthMethodName("length");
@@ -64,11 +66,18 @@ const std::string BuiltInTypes::arrayAppendAllMethodName("appendAll");
 const std::string BuiltInTypes::arrayConcatMethodName("concat");
 const std::string BuiltInTypes::arraySliceMethodName("slice");
 const std::string BuiltInTypes::processWaitMethodName("wait");
+const std::string BuiltInTypes::processGetPidMethodName("getPid");
 const std::string BuiltInTypes::boxTypeName("Box");
+const std::string BuiltInTypes::futureTypeName("Future");
 
 const Identifier CommonNames::cloneableTypeName("_Cloneable");
 const Identifier CommonNames::cloneMethodName("_clone");
 const Identifier CommonNames::deepCopyMethodName("_deepCopy");
+const Identifier CommonNames::isUniqueMethodName("_isUnique");
+const Identifier CommonNames::serializeMethodName("_serialize");
+const Identifier CommonNames::deserializeMethodName("_deserialize");
+const Identifier CommonNames::byteBufferTypeName("ByteBuffer");
+const Identifier CommonNames::bufferVariableName("buffer");
 const Identifier CommonNames::messageHandlerTypeName("MessageHandler");
 const Identifier CommonNames::matchSubjectName("__match_subject");
 const Identifier CommonNames::enumTagVariableName("$tag");
@@ -265,13 +274,15 @@ VariableDeclaration::VariableDeclaration(
     Node(l),
     type(t),
     identifier(i),
-    isMember(false) {}
+    isMember(false),
+    passedByValue(false) {}
 
 VariableDeclaration::VariableDeclaration(const VariableDeclaration& other) :
     Node(other),
     type(other.type ? other.type->clone() : nullptr),
     identifier(other.identifier),
-    isMember(other.isMember) {}
+    isMember(other.isMember),
+    passedByValue(other.passedByValue) {}
 
 VariableDeclaration* VariableDeclaration::create(
     Type* t,
@@ -329,6 +340,25 @@ Identifier Symbol::makeConvertableEnumName(const Identifier& enumName) {
     return enumName + "<$>";
 }
 
+Identifier Symbol::makeSerializeMembersName(const Identifier& className) {
+    return CommonNames::serializeMethodName + "$" + className;
+}
+
+// The type tag identifies the class of a serialized object. It is a 32-bit
+// FNV-1a hash of the class name, so it is the same in every program that is
+// built from the same message classes. Zero is reserved for null.
+int Symbol::makeTypeTag(const Identifier& className) {
+    unsigned int hash = 2166136261u;
+    for (auto c: className) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    if (hash == 0) {
+        hash = 1;
+    }
+    return static_cast<int>(hash);
+}
+
 Identifier Symbol::makeClosureClassName(
     const Identifier& userClassName,
     const Identifier& userMethodName,
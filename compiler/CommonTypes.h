@@ -285,10 +285,23 @@ public:
         return isMember;
     }
 
+    // Arguments of reference type are passed as const references, so that
+    // calling a method does not touch the reference count. An argument that
+    // the method takes over, by moving it somewhere on its last use, is
+    // passed by value instead so that a temporary can be moved all the way.
+    void setIsPassedByValue(bool p) {
+        passedByValue = p;
+    }
+
+    bool isPassedByValue() const {
+        return passedByValue;
+    }
+
 private:
     Type* type;
     Identifier identifier;
     bool isMember;
+    bool passedByValue;
 };
 
 class Expression;
@@ -332,6 +345,7 @@ private:
 namespace BuiltInTypes {
     extern const std::string objectEqualsMethodName;
     extern const std::string objectHashMethodName;
+    extern const std::string objectReferenceCountMethodName;
     extern const std::string arrayTypeName;
     extern const std::string arrayEachMethodName;
     extern const std::string arrayLengthMethodName;
@@ -342,7 +356,9 @@ namespace BuiltInTypes {
     extern const std::string arrayConcatMethodName;
     extern const std::string arraySliceMethodName;
     extern const std::string processWaitMethodName;
+    extern const std::string processGetPidMethodName;
     extern const std::string boxTypeName;
+    extern const std::string futureTypeName;
 }
 
 namespace CommonNames {
@@ -352,6 +368,11 @@ namespace CommonNames {
     extern const Identifier cloneableTypeName;
     extern const Identifier cloneMethodName;
     extern const Identifier deepCopyMethodName;
+    extern const Identifier isUniqueMethodName;
+    extern const Identifier serializeMethodName;
+    extern const Identifier deserializeMethodName;
+    extern const Identifier byteBufferTypeName;
+    extern const Identifier bufferVariableName;
     extern const Identifier otherVariableName;
     extern const Identifier callMethodName;
     extern const Identifier deferTypeName;
@@ -368,6 +389,8 @@ namespace Symbol {
     Identifier makeEnumVariantDataName(const Identifier& variantName);
     Identifier makeEnumVariantClassName(const Identifier& variantName);
     Identifier makeConvertableEnumName(const Identifier& enumName);
+    Identifier makeSerializeMembersName(const Identifier& className);
+    int makeTypeTag(const Identifier& className);
     Identifier makeClosureClassName(
         const Identifier& userClassName,
         const Identifier& userMethodName,
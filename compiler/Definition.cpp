@@ -9,6 +9,7 @@
 #include "Context.h"
 #include "Tree.h"
 #include "CloneGenerator.h"
+#include "SerializeGenerator.h"
 #include "EnumGenerator.h"
 
 namespace {
@@ -472,6 +473,18 @@ void ClassDefinition::generateEmptyCopyConstructor() {
     hasConstructor = tmp;
 }
 
+void ClassDefinition::generateEmptyDeserializingConstructor() {
+    // Like the copy constructor, this constructor is generated for message
+    // classes and does not count as a normal constructor.
+    bool tmp = hasConstructor;
+    auto deserializingConstructor =
+        MethodDefinition::create(Keyword::initString, nullptr, false, this);
+    deserializingConstructor->addArgument(CommonNames::byteBufferTypeName,
+                                          CommonNames::bufferVariableName);
+    appendMember(deserializingConstructor);
+    hasConstructor = tmp;
+}
+
 MethodDefinition* ClassDefinition::generateEmptyConstructor() {
     auto emptyConstructor =
         MethodDefinition::create(Keyword::initString, nullptr, false, this);
@@ -558,6 +571,7 @@ void ClassDefinition::generateCloneMethod() {
         if (allTypeParametersAreMessagesOrPrimitives()) {
             // Generate the cloning code for message class.
             CloneGenerator::generate(this, Tree::getCurrentTree());
+            SerializeGenerator::generate(this, Tree::getCurrentTree());
         } else {
             // Not all type parameters are messages or primitive types. This
             // means this class cannot implement the _Cloneable interface. This
@@ -565,19 +579,26 @@ void ClassDefinition::generateCloneMethod() {
             // class and the type parameters are not messages or primitives.
             removeCloneableParent();
             removeCopyConstructor();
+            removeDeserializingConstructor();
             removeMethod(CommonNames::cloneMethodName);
+            removeMethod(CommonNames::isUniqueMethodName);
+            removeMethod(CommonNames::serializeMethodName);
+            removeMethod(Symbol::makeSerializeMembersName(name));
         }
     } else if (properties.isEnumeration) {
         if (allTypeParametersAreMessagesOrPrimitives()) {
             // Generate the deepCopy code for message enum classes.
             EnumGenerator enumGenerator(this, Tree::getCurrentTree());
             enumGenerator.generateDeepCopyMethod();
+            enumGenerator.generateSerializeMethods();
         } else {
             // Not all type parameters are messages or primitive types. This
             // means this enum cannot have the deepCopy method. This can happen
             // when the enum is a generated enum class from a generic enum class
             // and the type parameters are not messages or primitives.
             removeMethod(CommonNames::deepCopyMethodName);
+            removeMethod(CommonNames::serializeMethodName);
+            removeMethod(CommonNames::deserializeMethodName);
         }
     }
 }
@@ -684,6 +705,23 @@ MethodDefinition* ClassDefinition::getCopyConstructor() const {
     return nullptr;
 }
 
+MethodDefinition* ClassDefinition::getDeserializingConstructor() const {
+    for (auto member: members) {
+        auto method = member->dynCast<MethodDefinition>();
+        if (method != nullptr && method->isConstructor()) {
+            const ArgumentList& arguments = method->getArgumentList();
+            if (arguments.size() == 1) {
+                auto argumentType = arguments.front()->getType();
+                if (argumentType->getName().compare(
+                        CommonNames::byteBufferTypeName) == 0) {
+                    return method;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
 ClassDefinition* ClassDefinition::getNestedClass(
     const Identifier& className) const {
 
@@ -809,6 +847,14 @@ void ClassDefinition::removeCopyConstructor() {
     }
 }
 
+void ClassDefinition::removeDeserializingConstructor() {
+    auto deserializingConstructor = getDeserializingConstructor();
+    auto i = std::find(members.begin(), members.end(), deserializingConstructor);
+    if (i != members.end()) {
+        members.erase(i);
+    }
+}
+
 void ClassDefinition::updateConstructorName() {
     Identifier newName = name + "_" + Keyword::initString;
     for (auto method: methods) {
@@ -1278,6 +1324,10 @@ void MethodDefinition::finishConstructor() {
     }
 
     auto classDefinition = getEnclosingClass();
+    if (body == nullptr) {
+        // Constructor of a native class.
+        return;
+    }
     if (!classDefinition->isEnumeration()) {
         const ClassDefinition* baseClass = classDefinition->getBaseClass();
         if (baseClass != nullptr &&
@@ -1621,6 +1671,10 @@ bool DataMemberDefinition::isDataMember(Definition* definition) {
     return definition->dynCast<DataMemberDefinition>() != nullptr;
 }
 
+bool DataMemberDefinition::isRuntimeOnly() const {
+    return isPrivate() && !getName().empty() && getName()[0] == '_';
+}
+
 void DataMemberDefinition::convertClosureType() {
     auto closureInterfaceType = Tree::convertToClosureInterface(type);
     if (closureInterfaceType != nullptr) {
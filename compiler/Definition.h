@@ -129,6 +129,7 @@ public:
     void generateDefaultConstructor();
     void generateDefaultConstructorIfNeeded();
     void generateEmptyCopyConstructor();
+    void generateEmptyDeserializingConstructor();
     MethodDefinition* getDefaultConstructor() const;
     bool isSubclassOf(const ClassDefinition* otherClass) const;
     bool isInheritingFromProcessInterface() const;
@@ -139,6 +140,7 @@ public:
     bool isReferenceType();
     MethodDefinition* getMainMethod() const;
     MethodDefinition* getCopyConstructor() const;
+    MethodDefinition* getDeserializingConstructor() const;
     ClassDefinition* getNestedClass(const Identifier& className) const;
     bool isGeneric() const;
     void setConcreteTypeParameters(
@@ -236,6 +238,7 @@ private:
     void removeCloneableParent();
     void removeMethod(const Identifier& methodName);
     void removeCopyConstructor();
+    void removeDeserializingConstructor();
     void updateConstructorName();
     MethodDefinition* generateEmptyConstructor();
     bool isMethodImplementingParentInterfaceMethod(
@@ -496,6 +499,11 @@ public:
 
     static bool isDataMember(Definition* definition);
 
+    // Private data members whose names start with an underscore are used only
+    // by the runtime. They are not copied when a message is cloned, and not
+    // serialized.
+    bool isRuntimeOnly() const;
+
     void setExpression(Expression* e) {
         expression = e;
     }
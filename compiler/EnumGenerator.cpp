@@ -2,11 +2,14 @@
 #include "Tree.h"
 #include "Expression.h"
 #include "Statement.h"
+#include "SerializeGenerator.h"
 
 namespace {
     const Identifier retvalVariableName("retval");
     const Identifier otherVariableName("other");
     const Identifier otherTagVariableName("otherTag");
+    const Identifier valueVariableName("value");
+    const Identifier valueTagVariableName("valueTag");
 
     void checkNonPrimitiveVariantDataMember(
         const VariableDeclaration* variantDataMember) {
@@ -62,15 +65,32 @@ namespace {
         }
     }
 
-    MethodDefinition* getDeepCopyMethod(const ClassDefinition* enumClass) {
+    MethodDefinition* getMethod(
+        const ClassDefinition* enumClass,
+        const Identifier& name) {
+
         for (auto method: enumClass->getMethods()) {
-            if (method->getName().compare(
-                    CommonNames::deepCopyMethodName) == 0) {
+            if (method->getName().compare(name) == 0) {
                 return method;
             }
         }
         return nullptr;
     }
+
+    MethodDefinition* getDeepCopyMethod(const ClassDefinition* enumClass) {
+        return getMethod(enumClass, CommonNames::deepCopyMethodName);
+    }
+
+    // Generate the following match case for the variants that have no
+    // matching case:
+    //
+    // _ -> {}
+    //
+    MatchCase* generateUnknownVariantMatchCase() {
+        auto unknownCase = MatchCase::create();
+        unknownCase->addPatternExpression(PlaceholderExpression::create());
+        return unknownCase;
+    }
 }
 
 EnumGenerator::EnumGenerator(
@@ -454,9 +474,7 @@ void EnumGenerator::generateDeepCopyMethod() {
             }
         }
     }
-    auto unknownCase = MatchCase::create();
-    unknownCase->addPatternExpression(PlaceholderExpression::create());
-    match->addCase(unknownCase);
+    match->addCase(generateUnknownVariantMatchCase());
     tree.addStatement(match);
 
     tree.addStatement(ReturnStatement::create(
@@ -529,6 +547,252 @@ MatchCase* EnumGenerator::generateVariantMatchCase(
     return matchCase;
 }
 
+// Generate the following methods:
+//
+// static _serialize([EnumName] value, ByteBuffer buffer) {}
+//
+// static [EnumName] _deserialize(ByteBuffer buffer) {
+//     [EnumName] retval
+// }
+//
+void EnumGenerator::generateEmptySerializeMethods() {
+    auto enumClassDef = tree.getCurrentClass();
+    const Location& location = enumClassDef->getLocation();
+
+    auto serializeMethod =
+        MethodDefinition::create(CommonNames::serializeMethodName,
+                                 Type::create(Type::Void),
+                                 AccessLevel::Public,
+                                 true,
+                                 enumClassDef,
+                                 location);
+    serializeMethod->setBody(tree.startBlock());
+    tree.finishBlock();
+    serializeMethod->addArgument(fullEnumType->clone(), valueVariableName);
+    serializeMethod->addArgument(CommonNames::byteBufferTypeName,
+                                 CommonNames::bufferVariableName);
+    tree.addClassMember(serializeMethod);
+
+    auto deserializeMethod =
+        MethodDefinition::create(CommonNames::deserializeMethodName,
+                                 fullEnumType->clone(),
+                                 AccessLevel::Public,
+                                 true,
+                                 enumClassDef,
+                                 location);
+    deserializeMethod->setBody(tree.startBlock());
+    tree.addStatement(
+        VariableDeclarationStatement::create(fullEnumType->clone(),
+                                             retvalVariableName,
+                                             nullptr,
+                                             location));
+    tree.finishBlock();
+    deserializeMethod->addArgument(CommonNames::byteBufferTypeName,
+                                   CommonNames::bufferVariableName);
+    deserializeMethod->setIsEnumCopyConstructor(true);
+    tree.addClassMember(deserializeMethod);
+}
+
+// Generate the bodies of the _serialize and _deserialize methods. See
+// generateSerializeMethodBody() and generateDeserializeMethodBody().
+void EnumGenerator::generateSerializeMethods() {
+    // Empty _serialize and _deserialize methods were created for the message
+    // enum when it was created. We will now generate the method bodies.
+    auto serializeMethod =
+        getMethod(enumClass, CommonNames::serializeMethodName);
+    auto deserializeMethod =
+        getMethod(enumClass, CommonNames::deserializeMethodName);
+    if (serializeMethod == nullptr || deserializeMethod == nullptr) {
+        // Convertable enums don't have the methods.
+        return;
+    }
+
+    tree.reopenClass(enumClass);
+    generateSerializeMethodBody(serializeMethod);
+    generateDeserializeMethodBody(deserializeMethod);
+    tree.finishClass();
+}
+
+// Generate the following method body:
+//
+// static _serialize([EnumName] value, ByteBuffer buffer) {
+//     int valueTag = value.$tag
+//     buffer.writeInt(valueTag)
+//     match valueTag {
+//          $[Variant0Name]Tag -> {
+//              [write value.$[Variant0Name].$0]
+//              ...
+//          }
+//          $[Variant1Name]Tag ->
+//              ...
+//          _ -> {}
+//     }
+// }
+//
+void EnumGenerator::generateSerializeMethodBody(
+    MethodDefinition* serializeMethod) {
+
+    tree.setCurrentBlock(serializeMethod->getBody());
+
+    const Location& location = tree.getCurrentClass()->getLocation();
+    tree.addStatement(
+        VariableDeclarationStatement::create(
+            Type::create(Type::Integer),
+            valueTagVariableName,
+            MemberSelectorExpression::create(valueVariableName,
+                                             CommonNames::enumTagVariableName),
+            location));
+    auto writeTagCall = MethodCallExpression::create("writeInt");
+    writeTagCall->addArgument(valueTagVariableName);
+    tree.addStatement(
+        MemberSelectorExpression::create(CommonNames::bufferVariableName,
+                                         writeTagCall));
+
+    auto match =
+        MatchExpression::create(
+            NamedEntityExpression::create(valueTagVariableName));
+    for (auto member: tree.getCurrentClass()->getMembers()) {
+        if (auto method = member->dynCast<MethodDefinition>()) {
+            if (method->isEnumConstructor()) {
+                match->addCase(generateVariantSerializeMatchCase(method));
+            }
+        }
+    }
+    match->addCase(generateUnknownVariantMatchCase());
+    tree.addStatement(match);
+
+    tree.finishBlock();
+}
+
+// Generate the following method body:
+//
+// static [EnumName] _deserialize(ByteBuffer buffer) {
+//     [EnumName] retval
+//     int valueTag = buffer.readInt
+//     retval.$tag = valueTag
+//     match valueTag {
+//          $[Variant0Name]Tag -> {
+//              [read retval.$[Variant0Name].$0]
+//              ...
+//          }
+//          $[Variant1Name]Tag ->
+//              ...
+//          _ -> {}
+//     }
+//     return retval
+// }
+//
+void EnumGenerator::generateDeserializeMethodBody(
+    MethodDefinition* deserializeMethod) {
+
+    tree.setCurrentBlock(deserializeMethod->getBody());
+
+    const Location& location = tree.getCurrentClass()->getLocation();
+    tree.addStatement(
+        VariableDeclarationStatement::create(
+            Type::create(Type::Integer),
+            valueTagVariableName,
+            MemberSelectorExpression::create(CommonNames::bufferVariableName,
+                                             "readInt"),
+            location));
+    tree.addStatement(
+        BinaryExpression::create(Operator::Assignment,
+                                 MemberSelectorExpression::create(
+                                     retvalVariableName,
+                                     CommonNames::enumTagVariableName),
+                                 NamedEntityExpression::create(
+                                    valueTagVariableName)));
+
+    auto match =
+        MatchExpression::create(
+            NamedEntityExpression::create(valueTagVariableName));
+    for (auto member: tree.getCurrentClass()->getMembers()) {
+        if (auto method = member->dynCast<MethodDefinition>()) {
+            if (method->isEnumConstructor()) {
+                match->addCase(generateVariantDeserializeMatchCase(method));
+            }
+        }
+    }
+    match->addCase(generateUnknownVariantMatchCase());
+    tree.addStatement(match);
+
+    tree.addStatement(ReturnStatement::create(
+        NamedEntityExpression::create(retvalVariableName)));
+    tree.finishBlock();
+}
+
+// Generate the following match case:
+//
+// $[Variant0Name]Tag -> {
+//     [write value.$[Variant0Name].$0]
+//     ...
+// }
+//
+MatchCase* EnumGenerator::generateVariantSerializeMatchCase(
+    const MethodDefinition* variantConstructor) {
+
+    auto matchCase = MatchCase::create();
+    const Identifier& variantName = variantConstructor->getName();
+    matchCase->addPatternExpression(
+        NamedEntityExpression::create(
+            Symbol::makeEnumVariantTagName(variantName)));
+    matchCase->setResultBlock(tree.startBlock());
+
+    Identifier enumVariantDataName(
+        Symbol::makeEnumVariantDataName(variantName));
+    for (auto variantDataMember: variantConstructor->getArgumentList()) {
+        auto variantDataType = variantDataMember->getType();
+        if (!variantDataType->isPrimitive()) {
+            checkNonPrimitiveVariantDataMember(variantDataMember);
+        }
+        auto value =
+            MemberSelectorExpression::create(
+                NamedEntityExpression::create(valueVariableName),
+                MemberSelectorExpression::create(
+                    enumVariantDataName,
+                    variantDataMember->getIdentifier()));
+        SerializeGenerator::generateWrite(value, variantDataType, tree);
+    }
+
+    tree.finishBlock();
+    return matchCase;
+}
+
+// Generate the following match case:
+//
+// $[Variant0Name]Tag -> {
+//     [read retval.$[Variant0Name].$0]
+//     ...
+// }
+//
+MatchCase* EnumGenerator::generateVariantDeserializeMatchCase(
+    const MethodDefinition* variantConstructor) {
+
+    auto matchCase = MatchCase::create();
+    const Identifier& variantName = variantConstructor->getName();
+    matchCase->addPatternExpression(
+        NamedEntityExpression::create(
+            Symbol::makeEnumVariantTagName(variantName)));
+    matchCase->setResultBlock(tree.startBlock());
+
+    Identifier enumVariantDataName(
+        Symbol::makeEnumVariantDataName(variantName));
+    for (auto variantDataMember: variantConstructor->getArgumentList()) {
+        auto target =
+            MemberSelectorExpression::create(
+                NamedEntityExpression::create(retvalVariableName),
+                MemberSelectorExpression::create(
+                    enumVariantDataName,
+                    variantDataMember->getIdentifier()));
+        SerializeGenerator::generateRead(target,
+                                         variantDataMember->getType(),
+                                         tree);
+    }
+
+    tree.finishBlock();
+    return matchCase;
+}
+
 // Generate the following class:
 //
 // class [EnumName]<_> {
@@ -23,6 +23,8 @@ public:
         const Location& location);
     void generateEmptyDeepCopyMethod();
     void generateDeepCopyMethod();
+    void generateEmptySerializeMethods();
+    void generateSerializeMethods();
     ClassDefinition* getConvertableEnum();
     ClassDefinition* getEnum();
 
@@ -70,6 +72,12 @@ private:
         const Location& location);
     MatchCase* generateVariantMatchCase(
         const MethodDefinition* variantConstructor);
+    void generateSerializeMethodBody(MethodDefinition* serializeMethod);
+    void generateDeserializeMethodBody(MethodDefinition* deserializeMethod);
+    MatchCase* generateVariantSerializeMatchCase(
+        const MethodDefinition* variantConstructor);
+    MatchCase* generateVariantDeserializeMatchCase(
+        const MethodDefinition* variantConstructor);
     ClassDefinition* generateConvertableEnum();
     void generateImplicitConversion();
 
@@ -0,0 +1,410 @@
+#include "EscapeAnalysis.h"
+
+#include <set>
+#include <vector>
+
+#include "Definition.h"
+#include "Statement.h"
+#include "Expression.h"
+
+namespace {
+    bool isObjectClassMethod(const MethodDefinition* method) {
+        return method != nullptr &&
+               method->getClass()->getName().compare(Keyword::objectString) ==
+                   0;
+    }
+
+    using MethodSet = std::set<const MethodDefinition*>;
+    using DeclarationList = std::vector<VariableDeclarationStatement*>;
+
+    // Checks that an object is only used to access its data members and to
+    // call its methods. The object is referred to either by a local variable,
+    // or by this when the methods of the object are checked. Any statement or
+    // expression that is not known to be harmless counts as an escape, so
+    // that constructs added to the language later are handled safely.
+    class UseChecker {
+    public:
+        UseChecker(
+            const ClassDefinition* c,
+            const Identifier& v,
+            MethodSet& m);
+
+        bool checkStatement(const Statement* statement);
+        bool checkMethod(const MethodDefinition* method);
+
+    private:
+        bool checkBlock(const BlockStatement* block);
+        bool checkExpression(const Expression* expression);
+        bool checkMemberSelector(const MemberSelectorExpression* selector);
+        bool checkSelected(const Expression* expression);
+        bool checkMemberOfObject(const Expression* expression);
+        bool checkMember(const Expression* member, bool isMemberOfObject);
+        bool checkMethodCall(
+            const MethodCallExpression* methodCall,
+            bool isCallOnObject);
+        bool isObject(const Expression* expression) const;
+
+        const ClassDefinition* classDefinition;
+
+        // Empty when the object is referred to by this.
+        Identifier variableName;
+
+        // Methods that have been checked, or are being checked, for uses of
+        // this. A method that calls itself is not checked again.
+        MethodSet& checkedMethods;
+    };
+
+    UseChecker::UseChecker(
+        const ClassDefinition* c,
+        const Identifier& v,
+        MethodSet& m) :
+        classDefinition(c),
+        variableName(v),
+        checkedMethods(m) {}
+
+    bool UseChecker::checkStatement(const Statement* statement) {
+        switch (statement->getKind()) {
+            case Statement::VarDeclaration: {
+                auto init = statement->cast<VariableDeclarationStatement>()->
+                    getInitExpression();
+                return init == nullptr || checkExpression(init);
+            }
+            case Statement::Block:
+                return checkBlock(statement->cast<BlockStatement>());
+            case Statement::ExpressionStatement:
+                return checkExpression(statement->cast<Expression>());
+            case Statement::If: {
+                auto ifStatement = statement->cast<IfStatement>();
+                auto elseBlock = ifStatement->getElseBlock();
+                return checkExpression(ifStatement->getExpression()) &&
+                       checkBlock(ifStatement->getBlock()) &&
+                       (elseBlock == nullptr || checkBlock(elseBlock));
+            }
+            case Statement::While: {
+                auto whileStatement = statement->cast<WhileStatement>();
+                return checkExpression(whileStatement->getExpression()) &&
+                       checkBlock(whileStatement->getBlock());
+            }
+            case Statement::For: {
+                auto forStatement = statement->cast<ForStatement>();
+                auto condition = forStatement->getConditionExpression();
+                auto iter = forStatement->getIterExpression();
+                return (condition == nullptr || checkExpression(condition)) &&
+                       (iter == nullptr || checkExpression(iter)) &&
+                       checkBlock(forStatement->getBlock());
+            }
+            case Statement::Return: {
+                auto expression =
+                    statement->cast<ReturnStatement>()->getExpression();
+                return expression == nullptr || checkExpression(expression);
+            }
+            case Statement::ConstructorCall: {
+                auto constructorCall =
+                    statement->cast<ConstructorCallStatement>()->
+                        getMethodCallExpression();
+                return checkMethodCall(
+                    constructorCall,
+                    variableName.empty() &&
+                        !isObjectClassMethod(
+                            constructorCall->getMethodDefinition()));
+            }
+            case Statement::Break:
+            case Statement::Continue:
+            case Statement::Label:
+            case Statement::Jump:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Check the uses of this in a method that is called on the object.
+    bool UseChecker::checkMethod(const MethodDefinition* method) {
+        if (method == nullptr) {
+            return false;
+        }
+        if (method->isStatic()) {
+            return true;
+        }
+        if (method->getClass() != classDefinition ||
+            method->getBody() == nullptr ||
+            method->getLambdaSignature() != nullptr) {
+            return false;
+        }
+        if (!checkedMethods.insert(method).second) {
+            return true;
+        }
+
+        UseChecker thisChecker(classDefinition, Identifier(), checkedMethods);
+        return thisChecker.checkBlock(method->getBody());
+    }
+
+    bool UseChecker::checkBlock(const BlockStatement* block) {
+        for (auto statement: block->getStatements()) {
+            if (!checkStatement(statement)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool UseChecker::checkExpression(const Expression* expression) {
+        if (isObject(expression)) {
+            // The object itself is used, not one of its members.
+            return false;
+        }
+
+        switch (expression->getKind()) {
+            case Expression::Literal: {
+                auto literal = expression->cast<LiteralExpression>();
+                if (literal->getKind() != LiteralExpression::Array) {
+                    return true;
+                }
+                auto arrayLiteral = expression->cast<ArrayLiteralExpression>();
+                for (auto element: arrayLiteral->getElements()) {
+                    if (!checkExpression(element)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case Expression::Binary: {
+                auto binary = expression->cast<BinaryExpression>();
+                return checkExpression(binary->getLeft()) &&
+                       checkExpression(binary->getRight());
+            }
+            case Expression::Unary:
+                return checkExpression(
+                    expression->cast<UnaryExpression>()->getOperand());
+            case Expression::MemberSelector:
+                return checkMemberSelector(
+                    expression->cast<MemberSelectorExpression>());
+            case Expression::Member:
+                // A member of this, without a member selector.
+                return checkMember(expression, variableName.empty());
+            case Expression::HeapAllocation:
+                return checkMethodCall(
+                    expression->cast<HeapAllocationExpression>()->
+                        getConstructorCall(),
+                    false);
+            case Expression::ArrayAllocation: {
+                auto allocation =
+                    expression->cast<ArrayAllocationExpression>();
+                auto capacity = allocation->getArrayCapacityExpression();
+                auto init = allocation->getInitExpression();
+                return (capacity == nullptr || checkExpression(capacity)) &&
+                       (init == nullptr || checkExpression(init));
+            }
+            case Expression::ArraySubscript: {
+                auto subscript = expression->cast<ArraySubscriptExpression>();
+                return checkExpression(subscript->getArrayNameExpression()) &&
+                       checkExpression(subscript->getIndexExpression());
+            }
+            case Expression::TypeCast:
+                return checkExpression(
+                    expression->cast<TypeCastExpression>()->getOperand());
+            case Expression::WrappedStatement:
+                return checkStatement(
+                    expression->cast<WrappedStatementExpression>()->
+                        getStatement());
+            case Expression::LocalVariable:
+            case Expression::ClassName:
+            case Expression::Null:
+            case Expression::This:
+            case Expression::Temporary:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool UseChecker::checkMemberSelector(
+        const MemberSelectorExpression* selector) {
+
+        auto left = selector->getLeft();
+        if (isObject(left)) {
+            return checkMemberOfObject(selector->getRight());
+        }
+        return checkExpression(left) && checkSelected(selector->getRight());
+    }
+
+    // Check the right-hand side of a member selector whose left-hand side is
+    // not the object.
+    bool UseChecker::checkSelected(const Expression* expression) {
+        if (expression->getKind() == Expression::Member) {
+            return checkMember(expression, false);
+        }
+        return checkExpression(expression);
+    }
+
+    // Check an expression that is selected from the object, like b in a.b,
+    // b[i] in a.b[i] or b.c in a.b.c.
+    bool UseChecker::checkMemberOfObject(const Expression* expression) {
+        switch (expression->getKind()) {
+            case Expression::Member:
+                return checkMember(expression, true);
+            case Expression::ArraySubscript: {
+                auto subscript = expression->cast<ArraySubscriptExpression>();
+                return checkMemberOfObject(
+                           subscript->getArrayNameExpression()) &&
+                       checkExpression(subscript->getIndexExpression());
+            }
+            case Expression::MemberSelector: {
+                auto selector = expression->cast<MemberSelectorExpression>();
+                return checkMemberOfObject(selector->getLeft()) &&
+                       checkSelected(selector->getRight());
+            }
+            default:
+                return false;
+        }
+    }
+
+    bool UseChecker::checkMember(
+        const Expression* member,
+        bool isMemberOfObject) {
+
+        auto memberExpression = member->cast<MemberExpression>();
+        switch (memberExpression->getKind()) {
+            case MemberExpression::DataMember:
+                return true;
+            case MemberExpression::MethodCall:
+                return checkMethodCall(
+                    member->cast<MethodCallExpression>(),
+                    isMemberOfObject);
+            default:
+                return false;
+        }
+    }
+
+    bool UseChecker::checkMethodCall(
+        const MethodCallExpression* methodCall,
+        bool isCallOnObject) {
+
+        if (methodCall->getLambda() != nullptr) {
+            return false;
+        }
+        for (auto argument: methodCall->getArguments()) {
+            if (!checkExpression(argument)) {
+                return false;
+            }
+        }
+        return !isCallOnObject || checkMethod(methodCall->getMethodDefinition());
+    }
+
+    bool UseChecker::isObject(const Expression* expression) const {
+        if (variableName.empty()) {
+            return expression->getKind() == Expression::This;
+        }
+        return expression->getKind() == Expression::LocalVariable &&
+               expression->cast<LocalVariableExpression>()->getName() ==
+                   variableName;
+    }
+
+    void collectDeclarations(Statement* statement, DeclarationList& found) {
+        switch (statement->getKind()) {
+            case Statement::VarDeclaration:
+                found.push_back(statement->cast<VariableDeclarationStatement>());
+                break;
+            case Statement::Block:
+                for (auto s: statement->cast<BlockStatement>()->
+                                 getStatements()) {
+                    collectDeclarations(s, found);
+                }
+                break;
+            case Statement::If: {
+                auto ifStatement = statement->cast<IfStatement>();
+                collectDeclarations(ifStatement->getBlock(), found);
+                if (ifStatement->getElseBlock() != nullptr) {
+                    collectDeclarations(ifStatement->getElseBlock(), found);
+                }
+                break;
+            }
+            case Statement::While:
+                collectDeclarations(
+                    statement->cast<WhileStatement>()->getBlock(), found);
+                break;
+            case Statement::For:
+                collectDeclarations(
+                    statement->cast<ForStatement>()->getBlock(), found);
+                break;
+            case Statement::ExpressionStatement: {
+                auto expression = statement->cast<Expression>();
+                if (expression->getKind() == Expression::WrappedStatement) {
+                    collectDeclarations(
+                        expression->cast<WrappedStatementExpression>()->
+                            getStatement(),
+                        found);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // The exact class of the object is known, so its methods can be checked.
+    // Inherited methods could call overridden ones, so only classes that
+    // inherit directly from object are considered.
+    bool mayBeStackAllocated(const ClassDefinition* classDefinition) {
+        if (classDefinition == nullptr ||
+            classDefinition->isInterface() ||
+            classDefinition->isProcess() ||
+            classDefinition->isClosure() ||
+            classDefinition->isEnumeration() ||
+            classDefinition->isGeneric()) {
+            return false;
+        }
+        auto baseClass = classDefinition->getBaseClass();
+        return baseClass == nullptr ||
+               baseClass->getName().compare(Keyword::objectString) == 0;
+    }
+
+    bool isStackAllocatable(
+        VariableDeclarationStatement* declaration,
+        const BlockStatement* methodBody) {
+
+        auto init = declaration->getInitExpression();
+        if (init == nullptr ||
+            init->getKind() != Expression::HeapAllocation ||
+            !declaration->getType()->isConstant()) {
+            return false;
+        }
+
+        auto allocation = init->cast<HeapAllocationExpression>();
+        auto type = allocation->getType();
+        if (type == nullptr || type->isArray()) {
+            return false;
+        }
+        auto classDefinition = type->getClass();
+        if (!mayBeStackAllocated(classDefinition)) {
+            return false;
+        }
+
+        MethodSet checkedMethods;
+        UseChecker thisChecker(classDefinition, Identifier(), checkedMethods);
+        if (!thisChecker.checkMethod(
+                allocation->getConstructorCall()->getMethodDefinition())) {
+            return false;
+        }
+
+        UseChecker variableChecker(classDefinition,
+                                   declaration->getIdentifier(),
+                                   checkedMethods);
+        return variableChecker.checkStatement(methodBody);
+    }
+}
+
+void EscapeAnalysis::findStackAllocatedObjects(MethodDefinition* method) {
+    BlockStatement* body = method->getBody();
+    if (body == nullptr || method->getLambdaSignature() != nullptr) {
+        return;
+    }
+
+    DeclarationList declarations;
+    collectDeclarations(body, declarations);
+    for (auto declaration: declarations) {
+        if (isStackAllocatable(declaration, body)) {
+            declaration->setIsStackAllocated(true);
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef EscapeAnalysis_h
+#define EscapeAnalysis_h
+
+class MethodDefinition;
+
+namespace EscapeAnalysis {
+    // Find the objects that are created in the method and that can not
+    // outlive it, and mark the variables they are assigned to as stack
+    // allocated.
+    void findStackAllocatedObjects(MethodDefinition* method);
+}
+
+#endif
@@ -294,7 +294,8 @@ NamedEntityExpression::NamedEntityExpression(
     const Location& loc) :
     Expression(Expression::NamedEntity, loc),
     identifier(i),
-    binding(nullptr) {}
+    binding(nullptr),
+    isLastUse(false) {}
 
 NamedEntityExpression* NamedEntityExpression::create(const Identifier& i) {
     return new NamedEntityExpression(i, Location());
@@ -308,7 +309,9 @@ NamedEntityExpression* NamedEntityExpression::create(
 }
 
 NamedEntityExpression* NamedEntityExpression::clone() const {
-    return new NamedEntityExpression(identifier, getLocation());
+    auto clone = new NamedEntityExpression(identifier, getLocation());
+    clone->isLastUse = isLastUse;
+    return clone;
 }
 
 bool NamedEntityExpression::resolve(Context& context) {
@@ -330,10 +333,12 @@ Expression* NamedEntityExpression::transform(Context& context) {
     switch (binding->getReferencedEntity()) { 
         case Binding::LocalObject: {
             auto type = binding->getLocalObject()->getType();
-            resolvedExpression =
+            auto localVariable =
                 LocalVariableExpression::create(type,
                                                 identifier,
                                                 getLocation());
+            localVariable->setIsLastUse(isLastUse);
+            resolvedExpression = localVariable;
             break;
         }
         case Binding::DataMember: {
@@ -439,7 +444,8 @@ LocalVariableExpression::LocalVariableExpression(
     const Location& loc) :
     Expression(Expression::LocalVariable, loc),
     identifier(i),
-    hasTransformed(false) {
+    hasTransformed(false),
+    lastUse(false) {
 
     type = t;
 }
@@ -448,7 +454,8 @@ LocalVariableExpression::LocalVariableExpression(
     const LocalVariableExpression& other) :
     Expression(other),
     identifier(other.identifier),
-    hasTransformed(other.hasTransformed) {}
+    hasTransformed(other.hasTransformed),
+    lastUse(other.lastUse) {}
 
 LocalVariableExpression* LocalVariableExpression::create(
     Type* t,
@@ -1013,6 +1020,10 @@ const Identifier& DataMemberExpression::getName() const {
     return memberDefinition->getName();
 }
 
+DataMemberDefinition* DataMemberExpression::getDataMemberDefinition() const {
+    return memberDefinition->cast<DataMemberDefinition>();
+}
+
 MethodCallExpression::MethodCallExpression(
     const Identifier& n,
     const Location& l) :
@@ -1053,6 +1064,15 @@ void MethodCallExpression::addArgument(const Identifier& argument) {
     arguments.push_back(NamedEntityExpression::create(argument, Location()));
 }
 
+// Returns null if the call has not been resolved, or if it calls a built-in
+// method.
+MethodDefinition* MethodCallExpression::getMethodDefinition() const {
+    if (memberDefinition == nullptr) {
+        return nullptr;
+    }
+    return memberDefinition->cast<MethodDefinition>();
+}
+
 MethodDefinition* MethodCallExpression::getEnumCtorMethodDefinition() const {
     if (memberDefinition != nullptr) {
         auto methodDef = memberDefinition->cast<MethodDefinition>();
@@ -1941,7 +1961,8 @@ ArraySubscriptExpression::ArraySubscriptExpression(
     Expression* i) :
     Expression(Expression::ArraySubscript, n->getLocation()),
     arrayNameExpression(n),
-    indexExpression(i) {}
+    indexExpression(i),
+    indexInBounds(false) {}
 
 ArraySubscriptExpression* ArraySubscriptExpression::create(
     Expression* n,
@@ -1951,8 +1972,10 @@ ArraySubscriptExpression* ArraySubscriptExpression::create(
 }
 
 Expression* ArraySubscriptExpression::clone() const {
-    return new ArraySubscriptExpression(arrayNameExpression->clone(),
-                                        indexExpression->clone());
+    auto clone = new ArraySubscriptExpression(arrayNameExpression->clone(),
+                                              indexExpression->clone());
+    clone->indexInBounds = indexInBounds;
+    return clone;
 }
 
 Expression* ArraySubscriptExpression::transform(Context& context) {
@@ -2202,7 +2225,8 @@ Type* BinaryExpression::typeCheck(Context& context) {
     switch (op) {
         case Operator::Equal:
         case Operator::NotEqual:
-            if (leftType->isEnumeration() || rightType->isEnumeration()) {
+            if ((leftType->isEnumeration() && !leftType->isArray()) ||
+                (rightType->isEnumeration() && !rightType->isArray())) {
                 Trace::error("Comparison operator is not compatible for "
                              "enumerated types.",
                              leftType,
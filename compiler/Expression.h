@@ -260,11 +260,18 @@ public:
         return binding;
     }
 
+    // Mark the expression as the last use of a local variable, which allows
+    // the backend to move the value instead of copying it.
+    void setIsLastUse() {
+        isLastUse = true;
+    }
+
 private:
     NamedEntityExpression(const Identifier& i, const Location& loc);
 
     Identifier identifier;
     Binding* binding;
+    bool isLastUse;
 };
 
 class LocalVariableExpression: public Expression {
@@ -284,12 +291,21 @@ public:
         return identifier;
     }
 
+    void setIsLastUse(bool l) {
+        lastUse = l;
+    }
+
+    bool isLastUse() const {
+        return lastUse;
+    }
+
 private:
     LocalVariableExpression(Type* t, const Identifier& i, const Location& loc);
     LocalVariableExpression(const LocalVariableExpression& other);
 
     Identifier identifier;
     bool hasTransformed;
+    bool lastUse;
 };
 
 class ClassNameExpression: public Expression {
@@ -603,6 +619,7 @@ public:
     Identifier generateVariableName() const override;
 
     const Identifier& getName() const;
+    DataMemberDefinition* getDataMemberDefinition() const;
 
 private:
     DataMemberExpression(DataMemberDefinition* d, const Location& loc);
@@ -625,6 +642,7 @@ public:
     void setConstructorCallName(const Type* allocatedObjectType);
     void addArgument(const Identifier& argument);
     MethodDefinition* getEnumCtorMethodDefinition() const;
+    MethodDefinition* getMethodDefinition() const;
     void tryResolveEnumConstructor(const Context& context);
 
     static MethodCallExpression* transformMethodCall(
@@ -803,6 +821,16 @@ public:
         return indexExpression;
     }
 
+    // The index is known to be within the bounds of the array, so the bounds
+    // check can be left out. See RangeAnalysis.
+    void setIsIndexInBounds(bool i) {
+        indexInBounds = i;
+    }
+
+    bool isIndexInBounds() const {
+        return indexInBounds;
+    }
+
 private:
     ArraySubscriptExpression(Expression* n, Expression* i);
 
@@ -812,6 +840,7 @@ private:
 
     Expression* arrayNameExpression;
     Expression* indexExpression;
+    bool indexInBounds;
 }; 
 
 class TypeCastExpression: public Expression {
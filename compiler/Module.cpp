@@ -44,6 +44,14 @@ void Module::compile() {
     // Do type checks and transform statements into a more low-level form.
     tree.typeCheckAndTransform();
 
+    // Find objects that can not outlive the method that creates them, so
+    // that they can be allocated on the stack instead of the heap.
+    tree.findStackAllocatedObjects();
+
+    // Find array subscripts in counted loops whose index is known to be in
+    // bounds, so that they can be generated without a bounds check.
+    tree.eliminateBoundsChecks();
+
     if (!native) {
         // Generate C++ code from the transformed AST.
         backEnd.generate(dependencies);
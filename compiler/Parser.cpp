@@ -104,6 +104,7 @@ void Parser::importDefaultModules() {
     importModule("Box.b");
     importModule("Process.b");
     importModule("Option.b");
+    importModule("Future.b");
 }
 
 void Parser::parse() {
@@ -625,6 +626,7 @@ void Parser::parseEnumeration(bool isMessage) {
 
     if (isMessage) {
         enumGenerator.generateEmptyDeepCopyMethod();
+        enumGenerator.generateEmptySerializeMethods();
     }
 
     auto convertableEnum = enumGenerator.getConvertableEnum();
@@ -14,9 +14,10 @@ namespace {
     const Identifier messageVariableName("message");
     const Identifier dataVariableName("data");
     const Identifier retvalVariableName("retval");
+    const Identifier resultVariableName("result");
+    const Identifier messageIdVariableName("messageId");
     const Identifier nameVariableName("name");
     const Identifier valueVariableName("value");
-    const Identifier idVariableName("id");
     const Identifier argVariableName("arg");
     const Identifier messageHandlerIdVariableName("messageHandlerId");
     const Identifier interfaceIdVariableName("interfaceId");
@@ -34,6 +35,16 @@ namespace {
     const Identifier receiveMethodResultMethodName("receiveMethodResult");
     const Identifier waitMethodName("wait");
 
+    const std::string asyncMethodNameSuffix("Async");
+
+    // Generate a reference to a local variable that is not used after this
+    // reference.
+    NamedEntityExpression* createLastUse(const Identifier& name) {
+        auto lastUse = NamedEntityExpression::create(name);
+        lastUse->setIsLastUse();
+        return lastUse;
+    }
+
     MethodDefinition* createWaitMethodSignature(
         ClassDefinition* classDef, 
         BlockStatement* body) {
@@ -46,6 +57,44 @@ namespace {
         return methodSignature;
     }
 
+    MethodDefinition* createGetPidMethodSignature(
+        ClassDefinition* classDef,
+        BlockStatement* body) {
+
+        auto methodSignature =
+            MethodDefinition::create(BuiltInTypes::processGetPidMethodName,
+                                     Type::create(Type::Integer),
+                                     classDef);
+        methodSignature->setBody(body);
+        return methodSignature;
+    }
+
+    // Create the following method signature:
+    //
+    // Future<[returnType]> [callType]Async([argType] arg1, ... )
+    //
+    MethodDefinition* createAsyncMethodSignature(
+        const MethodDefinition* remoteMethodSignature,
+        ClassDefinition* classDef,
+        BlockStatement* body) {
+
+        auto futureType = Type::create(BuiltInTypes::futureTypeName);
+        futureType->addGenericTypeParameter(
+            remoteMethodSignature->getReturnType()->clone());
+        auto methodSignature =
+            MethodDefinition::create(remoteMethodSignature->getName() +
+                                     asyncMethodNameSuffix,
+                                     futureType,
+                                     classDef);
+        methodSignature->setBody(body);
+
+        for (auto argument: remoteMethodSignature->getArgumentList()) {
+            methodSignature->addArgument(argument->getType()->clone(),
+                                         argument->getIdentifier());
+        }
+        return methodSignature;
+    }
+
     MethodDefinition* createGetProxyMethodSignature(
         ClassDefinition* classDef,
         BlockStatement* body,
@@ -143,9 +192,19 @@ void ProcessGenerator::transformIntoGeneratedProcessInterface(
 
     processClass->transformIntoInterface();
     fillRemoteMethodSignaturesList(processClass);
+    for (auto remoteMethodSignature: remoteMethodSignatures) {
+        if (!remoteMethodSignature->getReturnType()->isVoid()) {
+            processClass->appendMember(
+                createAsyncMethodSignature(remoteMethodSignature,
+                                           processClass,
+                                           nullptr));
+        }
+    }
     MethodDefinition* waitMethod = createWaitMethodSignature(processClass, 
                                                              nullptr);
     processClass->appendMember(waitMethod);
+    processClass->appendMember(createGetPidMethodSignature(processClass,
+                                                           nullptr));
 
     MethodDefinition* getProxyMethod =
         createGetProxyMethodSignature(processClass,
@@ -215,7 +274,8 @@ void ProcessGenerator::generateCallClasses() {
 //
 //     call(Message message, [ProcessType] processInstance) {
 //         let retval = new Box<[ReturnType]>(processInstance.[callType](arg))
-//         Process.send(sourcePid, message.createMethodResult(retval))
+//         let result = message.createMethodResult(retval)
+//         Process.send(sourcePid, result)
 //     }
 // }
 //
@@ -284,8 +344,7 @@ void ProcessGenerator::generateCallConstructor(
                       NamedEntityExpression::create(
                           argument->getIdentifier() + "_Arg"));
         } else {
-            rhs = NamedEntityExpression::create(
-                argument->getIdentifier() + "_Arg");
+            rhs = createLastUse(argument->getIdentifier() + "_Arg");
         }
         tree.addStatement(
             BinaryExpression::create(Operator::Assignment, lhs, rhs));
@@ -313,8 +372,14 @@ MethodDefinition* ProcessGenerator::generateCallConstructorSignature(
     }
 
     for (auto argument: remoteMethodSignature->getArgumentList()) {
-        methodSignature->addArgument(argument->getType()->clone(),
-                                     argument->getIdentifier() + "_Arg");
+        auto callArgument =
+            VariableDeclaration::create(argument->getType()->clone(),
+                                        argument->getIdentifier() + "_Arg",
+                                        argument->getLocation());
+
+        // The constructor moves the argument into the call.
+        callArgument->setIsPassedByValue(true);
+        methodSignature->addArgument(callArgument);
     }
     return methodSignature;
 }
@@ -323,7 +388,8 @@ MethodDefinition* ProcessGenerator::generateCallConstructorSignature(
 //
 // call(Message message, [ProcessType] processInstance) {
 //     let retval = new Box<[ReturnType]>(processInstance.[callType](arg))
-//     Process.send(sourcePid, message.createMethodResult(retval))
+//     let result = message.createMethodResult(retval)
+//     Process.send(sourcePid, result)
 // }
 //
 void ProcessGenerator::generateCallMethod(
@@ -340,7 +406,7 @@ void ProcessGenerator::generateCallMethod(
     } else {
         tree.addStatement(generateRetValDeclaration(remoteCallReturnType,
                                                     processMethodCall));
-        tree.addStatement(generateSendMethodResult());
+        generateSendMethodResult();
     }
 
     finishNonAbstractMethod(callMethod);
@@ -388,19 +454,30 @@ VariableDeclarationStatement* ProcessGenerator::generateRetValDeclaration(
                                                 initExpression);
 }
 
-// Generate the following expression:
+// Generate the following statements:
+//
+// let result = message.createMethodResult(retval)
+// Process.send(sourcePid, result)
 //
-// Process.send(sourcePid, message.createMethodResult(retval))
+// The result message is created in a statement of its own so that no
+// temporaries refer to it when it is sent. Then, if the returned object is
+// not referenced by the process anymore, the result can be handed over to the
+// calling process without being copied.
 //
-MemberSelectorExpression* ProcessGenerator::generateSendMethodResult() {
+void ProcessGenerator::generateSendMethodResult() {
     auto createMethodResult =
         MethodCallExpression::create(createMethodResultMethodName);
-    createMethodResult->addArgument(retvalVariableName);
+    createMethodResult->addArgument(createLastUse(retvalVariableName));
+    tree.addStatement(
+        VariableDeclarationStatement::create(
+            resultVariableName,
+            MemberSelectorExpression::create(messageVariableName,
+                                             createMethodResult)));
+
     auto send = MethodCallExpression::create(sendMethodName);
     send->addArgument(sourcePidVariableName);
-    send->addArgument(MemberSelectorExpression::create(messageVariableName,
-                                                       createMethodResult));
-    return MemberSelectorExpression::create(processTypeName, send);
+    send->addArgument(createLastUse(resultVariableName));
+    tree.addStatement(MemberSelectorExpression::create(processTypeName, send));
 }
 
 // Generate the following class:
@@ -475,6 +552,11 @@ void ProcessGenerator::generateInterfaceId(const Identifier& name, int id) {
 //     }
 // 
 //     [original process class method]*
+//
+//     // For each remote method that has a return value:
+//     Future<[returnType]> [callType]Async([argType] arg) {
+//         return new Future<[returnType]>(this.[callType](arg))
+//     }
 // 
 //     // If implementing process interfaces:
 //     [ProcessInterfaceType] get[ProcessInterfaceType]_Proxy() {
@@ -490,6 +572,10 @@ void ProcessGenerator::generateInterfaceId(const Identifier& name, int id) {
 // 
 //     wait() {
 //     }
+//
+//     int getPid() {
+//         return Process.getPid
+//     }
 // }
 // 
 void ProcessGenerator::generateMessageHandlerClass() {
@@ -501,8 +587,14 @@ void ProcessGenerator::generateMessageHandlerClass() {
 
     tree.getCurrentClass()->copyMembers(inputClass->getMembers());    
     generateHandleMessageMethod();
+    for (auto remoteMethodSignature: remoteMethodSignatures) {
+        if (!remoteMethodSignature->getReturnType()->isVoid()) {
+            generateMessageHandlerAsyncMethod(remoteMethodSignature);
+        }
+    }
     generateMessageHandlerGetProxyMethods();
     generateEmptyWaitMethod();
+    generateMessageHandlerGetPidMethod();
 
     finishClass();
 }
@@ -611,6 +703,37 @@ MemberSelectorExpression* ProcessGenerator::generateCastAndCall(
     return MemberSelectorExpression::create(typeCast, call);
 }
 
+// Generate the following method:
+//
+// Future<[returnType]> [callType]Async([argType] arg) {
+//     return new Future<[returnType]>(this.[callType](arg))
+// }
+//
+// A process that calls its own methods calls them directly, so the result is
+// known at once.
+//
+void ProcessGenerator::generateMessageHandlerAsyncMethod(
+    MethodDefinition* remoteMethodSignature) {
+
+    auto asyncMethod = createAsyncMethodSignature(remoteMethodSignature,
+                                                  tree.getCurrentClass(),
+                                                  tree.startBlock());
+
+    auto methodCall =
+        MethodCallExpression::create(remoteMethodSignature->getName());
+    for (auto argument: remoteMethodSignature->getArgumentList()) {
+        methodCall->addArgument(argument->getIdentifier());
+    }
+    tree.addStatement(
+        ReturnStatement::create(
+            generateFutureConstructorCall(
+                remoteMethodSignature->getReturnType(),
+                MemberSelectorExpression::create(ThisExpression::create(),
+                                                 methodCall))));
+
+    finishNonAbstractMethod(asyncMethod);
+}
+
 void ProcessGenerator::generateMessageHandlerGetProxyMethods() {
     if (inputClass->isInheritingFromProcessInterface()) {
         for (auto parent: inputClass->getParentClasses()) {
@@ -691,6 +814,24 @@ void ProcessGenerator::generateEmptyWaitMethod() {
     finishNonAbstractMethod(waitMethod);
 }
 
+// Generate the following method:
+//
+// int getPid() {
+//     return Process.getPid
+// }
+//
+void ProcessGenerator::generateMessageHandlerGetPidMethod() {
+    auto getPidMethod =
+        createGetPidMethodSignature(tree.getCurrentClass(), tree.startBlock());
+
+    tree.addStatement(
+        ReturnStatement::create(
+            MemberSelectorExpression::create(processTypeName,
+                                             getPidMethodName)));
+
+    finishNonAbstractMethod(getPidMethod);
+}
+
 // Generate the following class:
 //
 // class [ProcessType]_MessageHandlerFactory: MessageHandlerFactory {
@@ -750,9 +891,23 @@ void ProcessGenerator::generateMessageHandlerFactoryClass() {
 //         let message = new Message(
 //             MessageType.MethodCall,
 //             new [ProcessType]_[callType]_Call(Process.getPid, arg))
-//         Process.send(pid, message)
+//         let messageId = Process.send(pid, message)
 //         return ((Box<[returnType]>)
-//                     Process.receiveMethodResult(message.id).data).value
+//                     Process.receiveMethodResult(messageId).data).value
+//     }
+//
+//     // If the remote method has a return value and [ProcessType] is not a
+//     // process interface:
+//     Future<[returnType]> [callType]Async([argType] arg) {
+//         let message = new Message(
+//             MessageType.MethodCall,
+//             new [ProcessType]_[callType]_Call(Process.getPid, arg))
+//         let messageId = Process.send(pid, message)
+//         return new Future<[returnType]>(
+//             messageId,
+//             |Message result| {
+//                 return ((Box<[returnType]>) result.data).value
+//             })
 //     }
 //
 //     // If [ProcessType] inherits from a process interface:
@@ -767,6 +922,10 @@ void ProcessGenerator::generateMessageHandlerFactoryClass() {
 //     wait() {
 //         Process.wait(pid)
 //     }
+//
+//     int getPid() {
+//         return pid
+//     }
 // }
 //
 void ProcessGenerator::generateProxyClass() {
@@ -789,6 +948,10 @@ void ProcessGenerator::generateProxyClass() {
 
     for (auto remoteMethodSignature: remoteMethodSignatures) {
         generateProxyRemoteMethod(remoteMethodSignature);
+        if (!inputClass->isInterface() &&
+            !remoteMethodSignature->getReturnType()->isVoid()) {
+            generateProxyAsyncRemoteMethod(remoteMethodSignature);
+        }
     }
 
     if (inputClass->isInheritingFromProcessInterface()) {
@@ -801,6 +964,7 @@ void ProcessGenerator::generateProxyClass() {
 
     generateProxyGetProxyMethod(inputClassName);
     generateProxyWaitMethod();
+    generateProxyGetPidMethod();
 
     finishClass();
 }
@@ -891,11 +1055,16 @@ ProcessGenerator::generateProxyConstructorMethodSignatureWithPid(
 //     let message = new Message(
 //         MessageType.MethodCall,
 //         new [ProcessType]_[callType]_Call(Process.getPid, arg))
-//     Process.send(pid, message)
+//     let messageId = Process.send(pid, message)
 //     return ((Box<[returnType]>)
-//                 Process.receiveMethodResult(message.id).data).value
+//                 Process.receiveMethodResult(messageId).data).value
 // }
 //
+// The message and the arguments are not used after they have been put in the
+// message, so they are moved instead of copied. This allows Process.send to
+// hand over the message without copying it, unless the caller still
+// references any of the arguments.
+//
 void ProcessGenerator::generateProxyRemoteMethod(
     MethodDefinition* remoteMethodSignature) {
 
@@ -906,10 +1075,15 @@ void ProcessGenerator::generateProxyRemoteMethod(
     tree.addStatement(generateMessageDeclaration(remoteMethodSignature));
     auto send = MethodCallExpression::create(sendMethodName);
     send->addArgument(pidVariableName);
-    send->addArgument(messageVariableName);
-    tree.addStatement(MemberSelectorExpression::create(processTypeName, send));
+    send->addArgument(createLastUse(messageVariableName));
+    auto sendCall = MemberSelectorExpression::create(processTypeName, send);
     auto remoteCallReturnType = remoteMethodSignature->getReturnType();
-    if (!remoteCallReturnType->isVoid()) {
+    if (remoteCallReturnType->isVoid()) {
+        tree.addStatement(sendCall);
+    } else {
+        tree.addStatement(
+            VariableDeclarationStatement::create(messageIdVariableName,
+                                                 sendCall));
         tree.addStatement(
             generateMethodResultReturnStatement(remoteCallReturnType));
     }
@@ -917,6 +1091,96 @@ void ProcessGenerator::generateProxyRemoteMethod(
     finishNonAbstractMethod(proxyMethod);
 }
 
+// Generate the following method:
+//
+// Future<[returnType]> [callType]Async([argType] arg) {
+//     let message = new Message(
+//         MessageType.MethodCall,
+//         new [ProcessType]_[callType]_Call(Process.getPid, arg))
+//     let messageId = Process.send(pid, message)
+//     return new Future<[returnType]>(
+//         messageId,
+//         |Message result| { return ((Box<[returnType]>) result.data).value })
+// }
+//
+// Unlike the synchronous variant, the method returns as soon as the call has
+// been sent. The result is received when the caller awaits the future.
+//
+void ProcessGenerator::generateProxyAsyncRemoteMethod(
+    MethodDefinition* remoteMethodSignature) {
+
+    auto asyncMethod = createAsyncMethodSignature(remoteMethodSignature,
+                                                  tree.getCurrentClass(),
+                                                  tree.startBlock());
+
+    tree.addStatement(generateMessageDeclaration(remoteMethodSignature));
+    auto send = MethodCallExpression::create(sendMethodName);
+    send->addArgument(pidVariableName);
+    send->addArgument(createLastUse(messageVariableName));
+    tree.addStatement(
+        VariableDeclarationStatement::create(
+            messageIdVariableName,
+            MemberSelectorExpression::create(processTypeName, send)));
+
+    auto remoteCallReturnType = remoteMethodSignature->getReturnType();
+    tree.addStatement(
+        ReturnStatement::create(
+            generateFutureConstructorCall(
+                remoteCallReturnType,
+                NamedEntityExpression::create(messageIdVariableName),
+                generateUnpackResultFunction(remoteCallReturnType))));
+
+    finishNonAbstractMethod(asyncMethod);
+}
+
+// Generate the following expression:
+//
+// new Future<[returnType]>(argument)
+//
+// Or, if an unpack result function is given:
+//
+// new Future<[returnType]>(argument, unpackResultFunction)
+//
+Expression* ProcessGenerator::generateFutureConstructorCall(
+    Type* remoteCallReturnType,
+    Expression* argument,
+    Expression* unpackResultFunction) {
+
+    auto futureType = Type::create(BuiltInTypes::futureTypeName);
+    futureType->addGenericTypeParameter(remoteCallReturnType->clone());
+    auto futureConstructorCall =
+        MethodCallExpression::create(BuiltInTypes::futureTypeName);
+    futureConstructorCall->addArgument(argument);
+    if (unpackResultFunction != nullptr) {
+        futureConstructorCall->addArgument(unpackResultFunction);
+    }
+    return HeapAllocationExpression::create(futureType, futureConstructorCall);
+}
+
+// Generate the following anonymous function:
+//
+// |Message result| { return ((Box<[returnType]>) result.data).value }
+//
+Expression* ProcessGenerator::generateUnpackResultFunction(
+    Type* remoteCallReturnType) {
+
+    auto body = tree.startBlock();
+    tree.addStatement(
+        ReturnStatement::create(
+            generateMethodResultValue(
+                remoteCallReturnType,
+                MemberSelectorExpression::create(resultVariableName,
+                                                 dataVariableName))));
+    tree.finishBlock();
+
+    auto unpackResult =
+        AnonymousFunctionExpression::create(body, body->getLocation());
+    unpackResult->addArgument(
+        VariableDeclaration::create(Type::create(messageTypeName),
+                                    resultVariableName));
+    return unpackResult;
+}
+
 // Generate the following method signature:
 //
 // [returnType] [callType]([argType] arg1, ... )
@@ -1002,46 +1266,56 @@ Expression* ProcessGenerator::generateCallClassConstructorCallArgument(
             argument->getIdentifier(),
             "get" + argumentType->getName() + "_Proxy");
     }
-    return NamedEntityExpression::create(argument->getIdentifier());
+    return createLastUse(argument->getIdentifier());
 }
 
 // Generate the following statement:
 //
 // return ((Box<[returnType]>)
-//             Process.receiveMethodResult(message.id).data).value
+//             Process.receiveMethodResult(messageId).data).value
 //
 Statement* ProcessGenerator::generateMethodResultReturnStatement(
     Type* remoteCallReturnType) {
 
-    Type* returnType = nullptr;
-    if (remoteCallReturnType->isReference()) {
-        returnType = remoteCallReturnType->clone();
-    } else {
-        returnType = Type::create(BuiltInTypes::boxTypeName);
-        returnType->addGenericTypeParameter(remoteCallReturnType->clone());
-    }
     auto receiveMethodResult =
         MethodCallExpression::create(receiveMethodResultMethodName);
-    receiveMethodResult->addArgument(
-        MemberSelectorExpression::create(messageVariableName, idVariableName));
-    auto selector =
+    receiveMethodResult->addArgument(messageIdVariableName);
+    auto methodResultData =
         MemberSelectorExpression::create(
             processTypeName,
             MemberSelectorExpression::create(
                 receiveMethodResult,
                 NamedEntityExpression::create(dataVariableName)));
-    auto typeCast = TypeCastExpression::create(returnType, selector);
-    Expression* returnedExpression = nullptr;
+    return ReturnStatement::create(
+        generateMethodResultValue(remoteCallReturnType, methodResultData));
+}
+
+// Generate the following expression:
+//
+// ((Box<[returnType]>) [methodResultData]).value
+//
+// Or, if the return type is a reference type:
+//
+// ([returnType]) [methodResultData]
+//
+Expression* ProcessGenerator::generateMethodResultValue(
+    Type* remoteCallReturnType,
+    Expression* methodResultData) {
+
+    Type* returnType = nullptr;
     if (remoteCallReturnType->isReference()) {
-        returnedExpression = typeCast;
+        returnType = remoteCallReturnType->clone();
     } else {
-        returnedExpression =
-            MemberSelectorExpression::create(
-                typeCast,
-                NamedEntityExpression::create(valueVariableName));
+        returnType = Type::create(BuiltInTypes::boxTypeName);
+        returnType->addGenericTypeParameter(remoteCallReturnType->clone());
     }
-
-    return ReturnStatement::create(returnedExpression);
+    auto typeCast = TypeCastExpression::create(returnType, methodResultData);
+    if (remoteCallReturnType->isReference()) {
+        return typeCast;
+    }
+    return MemberSelectorExpression::create(
+        typeCast,
+        NamedEntityExpression::create(valueVariableName));
 }
 
 // Generate the following method:
@@ -1080,6 +1354,23 @@ void ProcessGenerator::generateProxyWaitMethod() {
     finishNonAbstractMethod(waitMethod);
 }
 
+// Generate the following method:
+//
+// int getPid() {
+//     return pid
+// }
+//
+void ProcessGenerator::generateProxyGetPidMethod() {
+    auto getPidMethod =
+        createGetPidMethodSignature(tree.getCurrentClass(), tree.startBlock());
+
+    tree.addStatement(
+        ReturnStatement::create(
+            NamedEntityExpression::create(pidVariableName)));
+
+    finishNonAbstractMethod(getPidMethod);
+}
+
 // Generate the following method signature:
 //
 // [ProcessType] get[ProcessType]_Proxy()
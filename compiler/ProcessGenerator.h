@@ -33,7 +33,7 @@ private:
     VariableDeclarationStatement* generateRetValDeclaration(
         Type* remoteCallReturnType,
         MemberSelectorExpression* processMethodCall);
-    MemberSelectorExpression* generateSendMethodResult();
+    void generateSendMethodResult();
     void generateInterfaceIdClass(bool generatedAsNestedClass = false);
     void generateInterfaceId(const Identifier& name, int id);
     void generateMessageHandlerClass();
@@ -43,11 +43,14 @@ private:
     MemberSelectorExpression* generateCastAndCall(
         const Identifier& processType);
     void generateInterfaceMatchCases(MatchExpression* match);
+    void generateMessageHandlerAsyncMethod(
+        MethodDefinition* remoteMethodSignature);
     void generateMessageHandlerGetProxyMethods();
     void generateMessageHandlerGetInterfaceProxyMethod(
         const Identifier& interfaceName);
     void generateMessageHandlerGetProcessProxyMethod();
     void generateEmptyWaitMethod();
+    void generateMessageHandlerGetPidMethod();
     void generateMessageHandlerFactoryClass();
     void generateProxyClass();
     void generateProxyConstructor(bool includeProcessName);
@@ -58,6 +61,13 @@ private:
     MethodDefinition* generateProxyConstructorMethodSignatureWithPid(
         BlockStatement* body);
     void generateProxyRemoteMethod(MethodDefinition* remoteMethodSignature);
+    void generateProxyAsyncRemoteMethod(
+        MethodDefinition* remoteMethodSignature);
+    Expression* generateFutureConstructorCall(
+        Type* remoteCallReturnType,
+        Expression* argument,
+        Expression* unpackResultFunction = nullptr);
+    Expression* generateUnpackResultFunction(Type* remoteCallReturnType);
     MethodDefinition* generateProxyRemoteMethodSignature(
         MethodDefinition* remoteMethodSignature,
         BlockStatement* body);
@@ -66,8 +76,11 @@ private:
     Expression* generateCallClassConstructorCallArgument(
         const VariableDeclaration* argument);
     Statement* generateMethodResultReturnStatement(Type* remoteCallReturnType);
+    Expression* generateMethodResultValue(Type* remoteCallReturnType,
+                                          Expression* methodResultData);
     void generateProxyGetProxyMethod(const Identifier& processOrInterfaceName);
     void generateProxyWaitMethod();
+    void generateProxyGetPidMethod();
     void generateGetProcessInterfaceProxyMethodSignature();
     void updateRegularClassConstructor();
     void generateRegularClassMessageHandlerMethod();
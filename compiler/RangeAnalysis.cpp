@@ -0,0 +1,712 @@
+#include "RangeAnalysis.h"
+
+#include <set>
+#include <vector>
+
+#include "Definition.h"
+#include "Statement.h"
+#include "Expression.h"
+
+// A subscript a[i] in a loop like
+//
+//     for var i = 0; i < n; i++ { ... a[i] ... }
+//
+// is in bounds if i starts at zero or above and is only changed by i++, and
+// the bound n is the length of a. The bound may also be a variable that holds
+// the length of a, or the length of another array that a has been checked to
+// be as long as. Arrays never get shorter, so an index that has been found to
+// be below the length of an array stays valid as long as the variable or data
+// member still refers to the same array.
+namespace {
+    using StatementSequence = std::vector<Statement*>;
+    using SubscriptList = std::vector<ArraySubscriptExpression*>;
+
+    // An array that is referred to by a local variable or by a data member of
+    // this.
+    struct ArrayName {
+        ArrayName() : dataMember(nullptr) {}
+
+        bool operator==(const ArrayName& other) const {
+            return variableName == other.variableName &&
+                   dataMember == other.dataMember;
+        }
+
+        Identifier variableName;
+        const DataMemberDefinition* dataMember;
+    };
+
+    using ArrayNameList = std::vector<ArrayName>;
+
+    bool isAssignment(Operator::Kind operatorKind) {
+        switch (operatorKind) {
+            case Operator::Assignment:
+            case Operator::AssignmentExpression:
+            case Operator::AdditionAssignment:
+            case Operator::SubtractionAssignment:
+            case Operator::MultiplicationAssignment:
+            case Operator::DivisionAssignment:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    const LocalVariableExpression* getLocalVariable(
+        const Expression* expression) {
+
+        if (expression->getKind() != Expression::LocalVariable) {
+            return nullptr;
+        }
+        return expression->cast<LocalVariableExpression>();
+    }
+
+    // A data member of this, either without a member selector or selected
+    // from this.
+    const DataMemberDefinition* getDataMemberOfThis(
+        const Expression* expression) {
+
+        if (expression->getKind() == Expression::MemberSelector) {
+            auto selector = expression->cast<MemberSelectorExpression>();
+            if (selector->getLeft()->getKind() != Expression::This) {
+                return nullptr;
+            }
+            expression = selector->getRight();
+        }
+        if (expression->getKind() != Expression::Member ||
+            expression->cast<MemberExpression>()->getKind() !=
+                MemberExpression::DataMember) {
+            return nullptr;
+        }
+        auto dataMember =
+            expression->cast<DataMemberExpression>()->
+                getDataMemberDefinition();
+        return dataMember->isStatic() ? nullptr : dataMember;
+    }
+
+    bool getArrayName(const Expression* expression, ArrayName& name) {
+        if (auto variable = getLocalVariable(expression)) {
+            name.variableName = variable->getName();
+            name.dataMember = nullptr;
+            return true;
+        }
+        name.variableName.clear();
+        name.dataMember = getDataMemberOfThis(expression);
+        return name.dataMember != nullptr;
+    }
+
+    bool isBuiltInArrayMethodCall(const MethodCallExpression* methodCall) {
+        auto method = methodCall->getMethodDefinition();
+        if (method == nullptr) {
+            return false;
+        }
+        auto classDefinition = method->getEnclosingClass();
+        return classDefinition != nullptr &&
+               classDefinition->getName().compare(
+                   BuiltInTypes::arrayTypeName) == 0;
+    }
+
+    // a.length or a.size.
+    bool isArrayLength(const Expression* expression, ArrayName& array) {
+        if (expression->getKind() != Expression::MemberSelector) {
+            return false;
+        }
+        auto selector = expression->cast<MemberSelectorExpression>();
+        auto right = selector->getRight();
+        if (right->getKind() != Expression::Member ||
+            right->cast<MemberExpression>()->getKind() !=
+                MemberExpression::MethodCall) {
+            return false;
+        }
+        auto methodCall = right->cast<MethodCallExpression>();
+        const Identifier& name = methodCall->getName();
+        return isBuiltInArrayMethodCall(methodCall) &&
+               (name.compare(BuiltInTypes::arrayLengthMethodName) == 0 ||
+                name.compare(BuiltInTypes::arraySizeMethodName) == 0) &&
+               getArrayName(selector->getLeft(), array);
+    }
+
+    bool isVariable(const Expression* expression, const Identifier& name) {
+        auto variable = getLocalVariable(expression);
+        return variable != nullptr && variable->getName() == name;
+    }
+
+    // What a piece of code may change. Local variables are changed by being
+    // assigned or declared, and data members by being assigned or by any
+    // method call, since the called method could assign them. Any statement
+    // or expression that is not known is assumed to change everything. The
+    // array subscripts in the code are collected too, unless the array or the
+    // index is a variable that is shadowed by a declaration in the code.
+    class Effects {
+    public:
+        Effects();
+
+        void addStatement(Statement* statement);
+        void addExpression(Expression* expression);
+        bool changes(const ArrayName& array) const;
+        bool changesVariable(const Identifier& name) const;
+
+        const SubscriptList& getSubscripts() const {
+            return subscripts;
+        }
+
+    private:
+        void addBlock(BlockStatement* block);
+        void addSelected(Expression* expression);
+        void addMethodCall(MethodCallExpression* methodCall);
+        void addAssignmentTo(Expression* target);
+        void addSubscript(ArraySubscriptExpression* subscript);
+        void declare(const Identifier& name);
+        bool isShadowed(const Identifier& name) const;
+
+        std::set<Identifier> changedVariables;
+        std::set<const DataMemberDefinition*> changedDataMembers;
+
+        // The names declared in the blocks that are being added. A variable
+        // that is declared outside of any block is still in scope after the
+        // code, so the declaration changes the variable.
+        std::vector<std::set<Identifier> > scopes;
+
+        SubscriptList subscripts;
+        bool callsMethods;
+        bool unknown;
+    };
+
+    Effects::Effects() : callsMethods(false), unknown(false) {}
+
+    void Effects::addStatement(Statement* statement) {
+        switch (statement->getKind()) {
+            case Statement::VarDeclaration: {
+                auto declaration =
+                    statement->cast<VariableDeclarationStatement>();
+                if (auto init = declaration->getInitExpression()) {
+                    addExpression(init);
+                }
+                declare(declaration->getIdentifier());
+                break;
+            }
+            case Statement::Block:
+                addBlock(statement->cast<BlockStatement>());
+                break;
+            case Statement::ExpressionStatement:
+                addExpression(statement->cast<Expression>());
+                break;
+            case Statement::If: {
+                auto ifStatement = statement->cast<IfStatement>();
+                addExpression(ifStatement->getExpression());
+                addBlock(ifStatement->getBlock());
+                if (ifStatement->getElseBlock() != nullptr) {
+                    addBlock(ifStatement->getElseBlock());
+                }
+                break;
+            }
+            case Statement::While: {
+                auto whileStatement = statement->cast<WhileStatement>();
+                addExpression(whileStatement->getExpression());
+                addBlock(whileStatement->getBlock());
+                break;
+            }
+            case Statement::For: {
+                auto forStatement = statement->cast<ForStatement>();
+                if (forStatement->getConditionExpression() != nullptr) {
+                    addExpression(forStatement->getConditionExpression());
+                }
+                if (forStatement->getIterExpression() != nullptr) {
+                    addExpression(forStatement->getIterExpression());
+                }
+                addBlock(forStatement->getBlock());
+                break;
+            }
+            case Statement::Return: {
+                auto expression =
+                    statement->cast<ReturnStatement>()->getExpression();
+                if (expression != nullptr) {
+                    addExpression(expression);
+                }
+                break;
+            }
+            case Statement::ConstructorCall:
+                addMethodCall(statement->cast<ConstructorCallStatement>()->
+                                  getMethodCallExpression());
+                callsMethods = true;
+                break;
+            case Statement::Break:
+            case Statement::Continue:
+            case Statement::Label:
+            case Statement::Jump:
+                break;
+            default:
+                unknown = true;
+                break;
+        }
+    }
+
+    void Effects::addBlock(BlockStatement* block) {
+        scopes.push_back(std::set<Identifier>());
+        for (auto statement: block->getStatements()) {
+            addStatement(statement);
+        }
+        scopes.pop_back();
+    }
+
+    void Effects::addExpression(Expression* expression) {
+        switch (expression->getKind()) {
+            case Expression::Literal: {
+                auto literal = expression->cast<LiteralExpression>();
+                if (literal->getKind() == LiteralExpression::Array) {
+                    auto arrayLiteral =
+                        expression->cast<ArrayLiteralExpression>();
+                    for (auto element: arrayLiteral->getElements()) {
+                        addExpression(element);
+                    }
+                }
+                break;
+            }
+            case Expression::Binary: {
+                auto binary = expression->cast<BinaryExpression>();
+                if (isAssignment(binary->getOperator())) {
+                    addAssignmentTo(binary->getLeft());
+                }
+                addExpression(binary->getLeft());
+                addExpression(binary->getRight());
+                break;
+            }
+            case Expression::Unary: {
+                auto unary = expression->cast<UnaryExpression>();
+                if (unary->getOperator() == Operator::Increment ||
+                    unary->getOperator() == Operator::Decrement) {
+                    addAssignmentTo(unary->getOperand());
+                }
+                addExpression(unary->getOperand());
+                break;
+            }
+            case Expression::MemberSelector: {
+                auto selector = expression->cast<MemberSelectorExpression>();
+                addExpression(selector->getLeft());
+                addSelected(selector->getRight());
+                break;
+            }
+            case Expression::Member:
+                if (expression->cast<MemberExpression>()->getKind() ==
+                    MemberExpression::MethodCall) {
+                    addMethodCall(expression->cast<MethodCallExpression>());
+                }
+                break;
+            case Expression::HeapAllocation:
+                addMethodCall(expression->cast<HeapAllocationExpression>()->
+                                  getConstructorCall());
+                callsMethods = true;
+                break;
+            case Expression::ArrayAllocation: {
+                auto allocation =
+                    expression->cast<ArrayAllocationExpression>();
+                if (allocation->getArrayCapacityExpression() != nullptr) {
+                    addExpression(allocation->getArrayCapacityExpression());
+                }
+                if (allocation->getInitExpression() != nullptr) {
+                    addExpression(allocation->getInitExpression());
+                }
+                break;
+            }
+            case Expression::ArraySubscript: {
+                auto subscript = expression->cast<ArraySubscriptExpression>();
+                addSubscript(subscript);
+                addExpression(subscript->getArrayNameExpression());
+                addExpression(subscript->getIndexExpression());
+                break;
+            }
+            case Expression::TypeCast:
+                addExpression(
+                    expression->cast<TypeCastExpression>()->getOperand());
+                break;
+            case Expression::WrappedStatement:
+                addStatement(
+                    expression->cast<WrappedStatementExpression>()->
+                        getStatement());
+                break;
+            case Expression::LocalVariable:
+            case Expression::ClassName:
+            case Expression::Null:
+            case Expression::This:
+            case Expression::Temporary:
+                break;
+            default:
+                unknown = true;
+                break;
+        }
+    }
+
+    // Add the right-hand side of a member selector. A data member that is
+    // selected from another object is not a data member of this.
+    void Effects::addSelected(Expression* expression) {
+        switch (expression->getKind()) {
+            case Expression::ArraySubscript: {
+                auto subscript = expression->cast<ArraySubscriptExpression>();
+                addSelected(subscript->getArrayNameExpression());
+                addExpression(subscript->getIndexExpression());
+                break;
+            }
+            case Expression::MemberSelector: {
+                auto selector = expression->cast<MemberSelectorExpression>();
+                addSelected(selector->getLeft());
+                addSelected(selector->getRight());
+                break;
+            }
+            default:
+                addExpression(expression);
+                break;
+        }
+    }
+
+    void Effects::addMethodCall(MethodCallExpression* methodCall) {
+        if (methodCall->getLambda() != nullptr) {
+            unknown = true;
+            return;
+        }
+        if (!isBuiltInArrayMethodCall(methodCall)) {
+            callsMethods = true;
+        }
+        for (auto argument: methodCall->getArguments()) {
+            addExpression(argument);
+        }
+    }
+
+    void Effects::addAssignmentTo(Expression* target) {
+        switch (target->getKind()) {
+            case Expression::LocalVariable: {
+                const Identifier& name =
+                    target->cast<LocalVariableExpression>()->getName();
+                if (!isShadowed(name)) {
+                    changedVariables.insert(name);
+                }
+                break;
+            }
+            case Expression::Member:
+                if (target->cast<MemberExpression>()->getKind() ==
+                    MemberExpression::DataMember) {
+                    // Whatever object the data member belongs to.
+                    changedDataMembers.insert(
+                        target->cast<DataMemberExpression>()->
+                            getDataMemberDefinition());
+                } else {
+                    unknown = true;
+                }
+                break;
+            case Expression::MemberSelector:
+                addAssignmentTo(
+                    target->cast<MemberSelectorExpression>()->getRight());
+                break;
+            case Expression::ArraySubscript:
+            case Expression::Temporary:
+                // Assigning an array element does not change which array a
+                // variable refers to, and temporaries are never bounds.
+                break;
+            default:
+                unknown = true;
+                break;
+        }
+    }
+
+    void Effects::addSubscript(ArraySubscriptExpression* subscript) {
+        auto index = getLocalVariable(subscript->getIndexExpression());
+        ArrayName array;
+        if (index != nullptr &&
+            !isShadowed(index->getName()) &&
+            getArrayName(subscript->getArrayNameExpression(), array) &&
+            (array.dataMember != nullptr ||
+             !isShadowed(array.variableName))) {
+            subscripts.push_back(subscript);
+        }
+    }
+
+    void Effects::declare(const Identifier& name) {
+        if (scopes.empty()) {
+            changedVariables.insert(name);
+        } else {
+            scopes.back().insert(name);
+        }
+    }
+
+    bool Effects::isShadowed(const Identifier& name) const {
+        for (const auto& scope: scopes) {
+            if (scope.count(name) != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Effects::changes(const ArrayName& array) const {
+        if (unknown) {
+            return true;
+        }
+        if (array.dataMember != nullptr) {
+            return callsMethods || changedDataMembers.count(array.dataMember);
+        }
+        return changedVariables.count(array.variableName) != 0;
+    }
+
+    bool Effects::changesVariable(const Identifier& name) const {
+        return unknown || changedVariables.count(name) != 0;
+    }
+
+    Effects getEffectsAfter(
+        const StatementSequence& statements,
+        StatementSequence::size_type position) {
+
+        Effects effects;
+        for (auto i = position + 1; i < statements.size(); i++) {
+            effects.addStatement(statements[i]);
+        }
+        return effects;
+    }
+
+    VariableDeclarationStatement* asDeclarationOf(
+        Statement* statement,
+        const Identifier& name) {
+
+        if (statement->getKind() != Statement::VarDeclaration) {
+            return nullptr;
+        }
+        auto declaration = statement->cast<VariableDeclarationStatement>();
+        return declaration->getIdentifier() == name ? declaration : nullptr;
+    }
+
+    // The index variable is an int that is declared with a non-negative
+    // integer literal and not changed before the loop.
+    bool startsAtZeroOrAbove(
+        const Identifier& indexName,
+        const StatementSequence& before) {
+
+        for (auto i = before.size(); i-- > 0; ) {
+            auto declaration = asDeclarationOf(before[i], indexName);
+            if (declaration == nullptr) {
+                continue;
+            }
+            auto type = declaration->getType();
+            auto init = declaration->getInitExpression();
+            if (type == nullptr ||
+                type->isArray() ||
+                type->getBuiltInType() != Type::Integer ||
+                init == nullptr ||
+                init->getKind() != Expression::Literal ||
+                init->cast<LiteralExpression>()->getKind() !=
+                    LiteralExpression::Integer ||
+                init->cast<IntegerLiteralExpression>()->getValue() < 0) {
+                return false;
+            }
+            return !getEffectsAfter(before, i).changesVariable(indexName);
+        }
+        return false;
+    }
+
+    // An if statement that leaves unless an array is at least as long as the
+    // bound, like 'if a.length != n { return false }'.
+    bool isLengthGuard(
+        Statement* statement,
+        const Identifier& boundName,
+        ArrayName& array) {
+
+        if (statement->getKind() != Statement::If) {
+            return false;
+        }
+        auto ifStatement = statement->cast<IfStatement>();
+        if (ifStatement->getElseBlock() != nullptr ||
+            ifStatement->getBlock()->mayFallThrough() ||
+            ifStatement->getExpression()->getKind() != Expression::Binary) {
+            return false;
+        }
+        auto condition = ifStatement->getExpression()->cast<BinaryExpression>();
+        auto operatorKind = condition->getOperator();
+        if ((operatorKind == Operator::NotEqual ||
+             operatorKind == Operator::Less) &&
+            isVariable(condition->getRight(), boundName)) {
+            return isArrayLength(condition->getLeft(), array);
+        }
+        if ((operatorKind == Operator::NotEqual ||
+             operatorKind == Operator::Greater) &&
+            isVariable(condition->getLeft(), boundName)) {
+            return isArrayLength(condition->getRight(), array);
+        }
+        return false;
+    }
+
+    // Find the arrays that are at least as long as the value of the bound
+    // variable, and that are still referred to by the same name in the loop.
+    void findArraysNotShorterThan(
+        const Identifier& boundName,
+        const StatementSequence& before,
+        const Effects& loop,
+        ArrayNameList& arrays) {
+
+        for (auto i = before.size(); i-- > 0; ) {
+            auto declaration = asDeclarationOf(before[i], boundName);
+            if (declaration == nullptr) {
+                continue;
+            }
+            Effects afterDeclaration = getEffectsAfter(before, i);
+            if (afterDeclaration.changesVariable(boundName) ||
+                loop.changesVariable(boundName)) {
+                return;
+            }
+            ArrayName array;
+            auto init = declaration->getInitExpression();
+            if (init != nullptr &&
+                isArrayLength(init, array) &&
+                !afterDeclaration.changes(array) &&
+                !loop.changes(array)) {
+                arrays.push_back(array);
+            }
+            for (auto j = i + 1; j < before.size(); j++) {
+                if (isLengthGuard(before[j], boundName, array) &&
+                    !getEffectsAfter(before, j).changes(array) &&
+                    !loop.changes(array)) {
+                    arrays.push_back(array);
+                }
+            }
+            return;
+        }
+    }
+
+    bool isIn(const ArrayName& array, const ArrayNameList& arrays) {
+        for (const auto& a: arrays) {
+            if (a == array) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The statements before the loop are the straight-line code that runs
+    // before it in the same iteration of any enclosing loop.
+    void findInBoundsSubscriptsInLoop(
+        ForStatement* forStatement,
+        const StatementSequence& before) {
+
+        auto condition = forStatement->getConditionExpression();
+        auto iter = forStatement->getIterExpression();
+        if (condition == nullptr ||
+            iter == nullptr ||
+            condition->getKind() != Expression::Binary ||
+            iter->getKind() != Expression::Unary) {
+            return;
+        }
+
+        // i < n and i++.
+        auto comparison = condition->cast<BinaryExpression>();
+        auto increment = iter->cast<UnaryExpression>();
+        auto index = getLocalVariable(comparison->getLeft());
+        if (comparison->getOperator() != Operator::Less ||
+            index == nullptr ||
+            increment->getOperator() != Operator::Increment ||
+            !isVariable(increment->getOperand(), index->getName())) {
+            return;
+        }
+
+        const Identifier& indexName = index->getName();
+        Effects loop;
+        loop.addExpression(condition);
+        loop.addStatement(forStatement->getBlock());
+        if (loop.changesVariable(indexName) ||
+            !startsAtZeroOrAbove(indexName, before)) {
+            return;
+        }
+
+        ArrayNameList arrays;
+        ArrayName array;
+        auto bound = comparison->getRight();
+        if (isArrayLength(bound, array)) {
+            if (!loop.changes(array)) {
+                arrays.push_back(array);
+            }
+        } else if (auto boundVariable = getLocalVariable(bound)) {
+            findArraysNotShorterThan(boundVariable->getName(),
+                                     before,
+                                     loop,
+                                     arrays);
+        }
+
+        for (auto subscript: loop.getSubscripts()) {
+            if (isVariable(subscript->getIndexExpression(), indexName) &&
+                getArrayName(subscript->getArrayNameExpression(), array) &&
+                isIn(array, arrays)) {
+                subscript->setIsIndexInBounds(true);
+            }
+        }
+    }
+
+    void findInBoundsSubscriptsInBlock(
+        BlockStatement* block,
+        StatementSequence before);
+
+    void findInBoundsSubscriptsInStatement(
+        Statement* statement,
+        const StatementSequence& before) {
+
+        switch (statement->getKind()) {
+            case Statement::Block:
+                findInBoundsSubscriptsInBlock(statement->cast<BlockStatement>(),
+                                              before);
+                break;
+            case Statement::ExpressionStatement: {
+                auto expression = statement->cast<Expression>();
+                if (expression->getKind() == Expression::WrappedStatement) {
+                    findInBoundsSubscriptsInStatement(
+                        expression->cast<WrappedStatementExpression>()->
+                            getStatement(),
+                        before);
+                }
+                break;
+            }
+            case Statement::If: {
+                auto ifStatement = statement->cast<IfStatement>();
+                StatementSequence beforeBranch(before);
+                beforeBranch.push_back(ifStatement->getExpression());
+                findInBoundsSubscriptsInBlock(ifStatement->getBlock(),
+                                              beforeBranch);
+                if (ifStatement->getElseBlock() != nullptr) {
+                    findInBoundsSubscriptsInBlock(ifStatement->getElseBlock(),
+                                                  beforeBranch);
+                }
+                break;
+            }
+            case Statement::While:
+                findInBoundsSubscriptsInBlock(
+                    statement->cast<WhileStatement>()->getBlock(),
+                    StatementSequence());
+                break;
+            case Statement::For: {
+                auto forStatement = statement->cast<ForStatement>();
+                findInBoundsSubscriptsInLoop(forStatement, before);
+                findInBoundsSubscriptsInBlock(forStatement->getBlock(),
+                                              StatementSequence());
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void findInBoundsSubscriptsInBlock(
+        BlockStatement* block,
+        StatementSequence before) {
+
+        for (auto statement: block->getStatements()) {
+            findInBoundsSubscriptsInStatement(statement, before);
+            if (statement->getKind() == Statement::Label) {
+                // The code after a label can be jumped to from anywhere.
+                before.clear();
+            } else {
+                before.push_back(statement);
+            }
+        }
+    }
+}
+
+void RangeAnalysis::findInBoundsSubscripts(MethodDefinition* method) {
+    BlockStatement* body = method->getBody();
+    if (body == nullptr || method->getLambdaSignature() != nullptr) {
+        return;
+    }
+
+    findInBoundsSubscriptsInBlock(body, StatementSequence());
+}
@@ -0,0 +1,13 @@
+#ifndef RangeAnalysis_h
+#define RangeAnalysis_h
+
+class MethodDefinition;
+
+namespace RangeAnalysis {
+    // Find the array subscripts in counted loops whose index is known to be
+    // within the bounds of the array, and mark them so that the bounds check
+    // can be left out.
+    void findInBoundsSubscripts(MethodDefinition* method);
+}
+
+#endif
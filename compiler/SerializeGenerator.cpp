@@ -0,0 +1,538 @@
+#include "SerializeGenerator.h"
+
+#include "Expression.h"
+#include "Statement.h"
+
+namespace {
+    const Identifier elementVariableName("$element");
+    const Identifier lengthVariableName("$length");
+    const Identifier writePrefix("write");
+    const Identifier readPrefix("read");
+    const Identifier arraySuffix("Array");
+    const Identifier writeIntMethodName("writeInt");
+    const Identifier readIntMethodName("readInt");
+    const Identifier readObjectMethodName("readObject");
+
+    // Must match the values that the ByteBuffer class writes in place of null.
+    const int nullObjectTag = 0;
+    const int nullArrayLength = -1;
+
+    MethodDefinition* getMethod(
+        const ClassDefinition *classDef,
+        const Identifier& name) {
+
+        for (auto method: classDef->getMethods()) {
+            if (method->getName().compare(name) == 0) {
+                return method;
+            }
+        }
+        return nullptr;
+    }
+
+    // Generate the following expression:
+    //
+    // buffer.methodName(argument)
+    //
+    Expression* generateBufferCall(
+        const Identifier& methodName,
+        Expression* argument) {
+
+        auto call = MethodCallExpression::create(methodName);
+        if (argument != nullptr) {
+            call->addArgument(argument);
+        }
+        return MemberSelectorExpression::create(
+            NamedEntityExpression::create(CommonNames::bufferVariableName),
+            call);
+    }
+
+    // Generate the following expression:
+    //
+    // value == null
+    //
+    Expression* generateIsNull(Expression* value) {
+        return BinaryExpression::create(Operator::Equal,
+                                        value,
+                                        NullExpression::create(Location()));
+    }
+
+    // Generate the following expression:
+    //
+    // value._serialize(buffer)
+    //
+    Expression* generateSerializeCall(Expression* value) {
+        auto serializeCall =
+            MethodCallExpression::create(CommonNames::serializeMethodName);
+        serializeCall->addArgument(CommonNames::bufferVariableName);
+        return MemberSelectorExpression::create(value, serializeCall);
+    }
+
+    // Generate the following code:
+    //
+    // if value == null {
+    //     buffer.writeInt(nullObjectTag)
+    // } else {
+    //     value._serialize(buffer)
+    // }
+    //
+    void generateReferenceWrite(Expression* value, Tree& tree) {
+        auto nullBlock = tree.startBlock();
+        tree.addStatement(
+            generateBufferCall(writeIntMethodName,
+                               IntegerLiteralExpression::create(
+                                   nullObjectTag)));
+        tree.finishBlock();
+
+        auto elseBlock = tree.startBlock();
+        tree.addStatement(generateSerializeCall(value->clone()));
+        tree.finishBlock();
+
+        tree.addStatement(IfStatement::create(generateIsNull(value),
+                                              nullBlock,
+                                              elseBlock,
+                                              Location()));
+    }
+
+    // Generate the following code:
+    //
+    // if value == null {
+    //     buffer.writeInt(nullArrayLength)
+    // } else {
+    //     buffer.writeInt(value.length)
+    //     value.each |$element| {
+    //         [write $element]
+    //     }
+    // }
+    //
+    void generateArrayWrite(
+        Expression* value,
+        Type* elementType,
+        Tree& tree) {
+
+        auto nullBlock = tree.startBlock();
+        tree.addStatement(
+            generateBufferCall(writeIntMethodName,
+                               IntegerLiteralExpression::create(
+                                   nullArrayLength)));
+        tree.finishBlock();
+
+        auto elseBlock = tree.startBlock();
+        tree.addStatement(
+            generateBufferCall(
+                writeIntMethodName,
+                MemberSelectorExpression::create(
+                    value->clone(),
+                    NamedEntityExpression::create(
+                        BuiltInTypes::arrayLengthMethodName))));
+
+        auto eachCall =
+            MethodCallExpression::create(BuiltInTypes::arrayEachMethodName);
+        auto lambdaBody = tree.startBlock();
+        auto lambda = LambdaExpression::create(lambdaBody);
+        auto elementName =
+            VariableDeclarationStatement::generateTemporaryName(
+                elementVariableName);
+        lambda->addArgument(
+            VariableDeclarationStatement::create(Type::create(Type::Implicit),
+                                                 elementName,
+                                                 nullptr,
+                                                 Location()));
+        SerializeGenerator::generateWrite(
+            NamedEntityExpression::create(elementName),
+            elementType,
+            tree);
+        tree.finishBlock();
+        eachCall->setLambda(lambda);
+        tree.addStatement(
+            MemberSelectorExpression::create(value->clone(), eachCall));
+        tree.finishBlock();
+
+        tree.addStatement(IfStatement::create(generateIsNull(value),
+                                              nullBlock,
+                                              elseBlock,
+                                              Location()));
+    }
+
+    // Generate the following code:
+    //
+    // var int $length = buffer.readInt
+    // if $length != nullArrayLength {
+    //     target = new ElementType[$length]
+    //     while $length > 0 {
+    //         [read element]
+    //         target.append(element)
+    //         $length = $length - 1
+    //     }
+    // }
+    //
+    void generateArrayRead(
+        Expression* target,
+        Type* arrayType,
+        Type* elementType,
+        Tree& tree) {
+
+        auto lengthName =
+            VariableDeclarationStatement::generateTemporaryName(
+                lengthVariableName);
+        auto lengthType = Type::create(Type::Integer);
+        lengthType->setConstant(false);
+        tree.addStatement(
+            VariableDeclarationStatement::create(
+                lengthType,
+                lengthName,
+                generateBufferCall(readIntMethodName, nullptr),
+                Location()));
+
+        auto notNullBlock = tree.startBlock();
+        tree.addStatement(
+            BinaryExpression::create(
+                Operator::Assignment,
+                target->clone(),
+                ArrayAllocationExpression::create(
+                    arrayType->clone(),
+                    NamedEntityExpression::create(lengthName))));
+
+        auto loopBody = tree.startBlock();
+        auto appendCall =
+            MethodCallExpression::create(BuiltInTypes::arrayAppendMethodName);
+        appendCall->addArgument(
+            SerializeGenerator::generateRead(elementType));
+        tree.addStatement(
+            MemberSelectorExpression::create(target->clone(), appendCall));
+        tree.addStatement(
+            BinaryExpression::create(
+                Operator::Assignment,
+                NamedEntityExpression::create(lengthName),
+                BinaryExpression::create(Operator::Subtraction,
+                                         NamedEntityExpression::create(
+                                             lengthName),
+                                         IntegerLiteralExpression::create(1))));
+        tree.finishBlock();
+        tree.addStatement(
+            WhileStatement::create(
+                BinaryExpression::create(Operator::Greater,
+                                         NamedEntityExpression::create(
+                                             lengthName),
+                                         IntegerLiteralExpression::create(0)),
+                loopBody,
+                Location()));
+        tree.finishBlock();
+
+        tree.addStatement(
+            IfStatement::create(
+                BinaryExpression::create(Operator::NotEqual,
+                                         NamedEntityExpression::create(
+                                             lengthName),
+                                         IntegerLiteralExpression::create(
+                                             nullArrayLength)),
+                notNullBlock,
+                nullptr,
+                Location()));
+    }
+
+    // Generate the following method:
+    //
+    // _serialize(ByteBuffer buffer) {
+    //     buffer.writeInt([TypeTag])
+    //     _serialize$ClassName(buffer)
+    // }
+    //
+    void generateSerializeMethod(ClassDefinition* inputClass, Tree& tree) {
+        // An empty _serialize method was created for the message class when
+        // the class was created. We will now generate the method body.
+        auto serializeMethod =
+            getMethod(inputClass, CommonNames::serializeMethodName);
+        tree.setCurrentBlock(serializeMethod->getBody());
+
+        tree.addStatement(
+            generateBufferCall(
+                writeIntMethodName,
+                IntegerLiteralExpression::create(
+                    Symbol::makeTypeTag(inputClass->getName()))));
+
+        auto serializeMembersCall =
+            MethodCallExpression::create(
+                Symbol::makeSerializeMembersName(inputClass->getName()));
+        serializeMembersCall->addArgument(CommonNames::bufferVariableName);
+        tree.addStatement(serializeMembersCall);
+
+        tree.finishBlock();
+    }
+
+    // Generate the following method:
+    //
+    // _serialize$ClassName(ByteBuffer buffer) {
+    //     _serialize$BaseClassName(buffer)
+    //     [write member]
+    //     ...
+    // }
+    //
+    // The members of each class in the hierarchy are written by a method of
+    // its own, since the private members of a base class cannot be accessed
+    // from the derived class.
+    void generateSerializeMembersMethod(
+        ClassDefinition* inputClass,
+        Tree& tree) {
+
+        auto serializeMembersMethod =
+            getMethod(inputClass,
+                      Symbol::makeSerializeMembersName(inputClass->getName()));
+        tree.setCurrentBlock(serializeMembersMethod->getBody());
+
+        auto baseClass = inputClass->getBaseClass();
+        if (baseClass != nullptr &&
+            baseClass->getName().compare(Keyword::objectString) != 0) {
+            auto baseSerializeMembersCall =
+                MethodCallExpression::create(
+                    Symbol::makeSerializeMembersName(baseClass->getName()));
+            baseSerializeMembersCall->addArgument(
+                CommonNames::bufferVariableName);
+            tree.addStatement(baseSerializeMembersCall);
+        }
+
+        for (auto dataMember: inputClass->getDataMembers()) {
+            if (dataMember->isStatic() || dataMember->isRuntimeOnly()) {
+                continue;
+            }
+            SerializeGenerator::generateWrite(
+                NamedEntityExpression::create(dataMember->getName()),
+                dataMember->getType(),
+                tree);
+        }
+
+        tree.finishBlock();
+    }
+
+    // Generate the following constructor:
+    //
+    // init(ByteBuffer buffer): BaseClassName(buffer) {
+    //     [read member]
+    //     ...
+    // }
+    //
+    void generateDeserializingConstructor(
+        ClassDefinition* inputClass,
+        Tree& tree) {
+
+        // An empty deserializing constructor was created for the message class
+        // when the class was created. We will now generate the body.
+        auto deserializingConstructor =
+            inputClass->getDeserializingConstructor();
+        tree.setCurrentBlock(deserializingConstructor->getBody());
+
+        auto baseClass = inputClass->getBaseClass();
+        if (baseClass != nullptr &&
+            baseClass->getName().compare(Keyword::objectString) != 0) {
+            auto constructorCall =
+                MethodCallExpression::create(baseClass->getName());
+            constructorCall->addArgument(CommonNames::bufferVariableName);
+            tree.addStatement(
+                ConstructorCallStatement::create(constructorCall));
+        }
+
+        for (auto dataMember: inputClass->getDataMembers()) {
+            if (dataMember->isStatic() || dataMember->isRuntimeOnly()) {
+                continue;
+            }
+            SerializeGenerator::generateRead(
+                NamedEntityExpression::create(dataMember->getName()),
+                dataMember->getType(),
+                tree);
+        }
+
+        tree.finishBlock();
+    }
+}
+
+void SerializeGenerator::generate(ClassDefinition* inputClass, Tree& tree) {
+    tree.reopenClass(inputClass);
+
+    generateSerializeMethod(inputClass, tree);
+    generateSerializeMembersMethod(inputClass, tree);
+    generateDeserializingConstructor(inputClass, tree);
+
+    tree.finishClass();
+}
+
+// Generate the following methods:
+//
+// init(ByteBuffer buffer) {}
+// _serialize(ByteBuffer buffer) {}
+// _serialize$ClassName(ByteBuffer buffer) {}
+//
+void SerializeGenerator::generateEmptySerializeMethods(
+    ClassDefinition *classDef) {
+
+    classDef->generateEmptyDeserializingConstructor();
+
+    auto serializeMethod =
+        MethodDefinition::create(CommonNames::serializeMethodName,
+                                 Type::create(Type::Void),
+                                 false,
+                                 classDef);
+    serializeMethod->addArgument(CommonNames::byteBufferTypeName,
+                                 CommonNames::bufferVariableName);
+    classDef->appendMember(serializeMethod);
+
+    auto serializeMembersMethod =
+        MethodDefinition::create(
+            Symbol::makeSerializeMembersName(classDef->getName()),
+            Type::create(Type::Void),
+            false,
+            classDef);
+    serializeMembersMethod->addArgument(CommonNames::byteBufferTypeName,
+                                        CommonNames::bufferVariableName);
+    classDef->appendMember(serializeMembersMethod);
+}
+
+// Generate the code that writes a value of the given type to the buffer:
+//
+// // If the value is of primitive type:
+// buffer.write[Type](value)
+//
+// // If the value is of enum type:
+// [Type]._serialize(value, buffer)
+//
+// // If the value is an array of primitive type:
+// buffer.write[ElementType]Array(value)
+//
+// // If the value is an array of reference type or enum type:
+// if value == null {
+//     buffer.writeInt(-1)
+// } else {
+//     buffer.writeInt(value.length)
+//     value.each |$element| {
+//         [write $element]
+//     }
+// }
+//
+// // If the value is of reference type:
+// if value == null {
+//     buffer.writeInt(0)
+// } else {
+//     value._serialize(buffer)
+// }
+//
+void SerializeGenerator::generateWrite(
+    Expression* value,
+    Type* type,
+    Tree& tree) {
+
+    if (type->isArray()) {
+        auto elementType = Type::createArrayElementType(type);
+        if (elementType->isPrimitive()) {
+            tree.addStatement(
+                generateBufferCall(writePrefix +
+                                   getPrimitiveTypeSuffix(elementType) +
+                                   arraySuffix,
+                                   value));
+        } else {
+            generateArrayWrite(value, elementType, tree);
+        }
+    } else if (type->isPrimitive()) {
+        tree.addStatement(
+            generateBufferCall(writePrefix + getPrimitiveTypeSuffix(type),
+                               value));
+    } else if (type->isEnumeration()) {
+        auto serializeCall =
+            MethodCallExpression::create(CommonNames::serializeMethodName);
+        serializeCall->addArgument(value);
+        serializeCall->addArgument(CommonNames::bufferVariableName);
+        tree.addStatement(
+            MemberSelectorExpression::create(type->getFullConstructedName(),
+                                             serializeCall));
+    } else {
+        generateReferenceWrite(value, tree);
+    }
+}
+
+// Generate the code that reads a value of the given type from the buffer
+// into the target:
+//
+// // If the value is not an array of reference type or enum type:
+// target = [read value]
+//
+// // Otherwise:
+// var int $length = buffer.readInt
+// if $length != -1 {
+//     target = new ElementType[$length]
+//     while $length > 0 {
+//         target.append([read element])
+//         $length = $length - 1
+//     }
+// }
+//
+void SerializeGenerator::generateRead(
+    Expression* target,
+    Type* type,
+    Tree& tree) {
+
+    if (type->isArray()) {
+        auto elementType = Type::createArrayElementType(type);
+        if (!elementType->isPrimitive()) {
+            generateArrayRead(target, type, elementType, tree);
+            return;
+        }
+    }
+    tree.addStatement(
+        BinaryExpression::create(Operator::Assignment,
+                                 target,
+                                 generateRead(type)));
+}
+
+// Generate the following expression:
+//
+// // If the value is of primitive type:
+// buffer.read[Type]
+//
+// // If the value is of enum type:
+// [Type]._deserialize(buffer)
+//
+// // If the value is an array of primitive type:
+// buffer.read[ElementType]Array
+//
+// // If the value is of reference type:
+// ([Type]) buffer.readObject
+//
+Expression* SerializeGenerator::generateRead(Type* type) {
+    if (type->isArray()) {
+        auto elementType = Type::createArrayElementType(type);
+        return generateBufferCall(readPrefix +
+                                  getPrimitiveTypeSuffix(elementType) +
+                                  arraySuffix,
+                                  nullptr);
+    } else if (type->isPrimitive()) {
+        return generateBufferCall(readPrefix + getPrimitiveTypeSuffix(type),
+                                  nullptr);
+    } else if (type->isEnumeration()) {
+        auto deserializeCall =
+            MethodCallExpression::create(CommonNames::deserializeMethodName);
+        deserializeCall->addArgument(CommonNames::bufferVariableName);
+        return MemberSelectorExpression::create(type->getFullConstructedName(),
+                                                deserializeCall);
+    } else {
+        return TypeCastExpression::create(
+            type->clone(),
+            generateBufferCall(readObjectMethodName, nullptr));
+    }
+}
+
+Identifier SerializeGenerator::getPrimitiveTypeSuffix(const Type* type) {
+    switch (type->getBuiltInType()) {
+        case Type::Boolean:
+            return "Bool";
+        case Type::Byte:
+            return "Byte";
+        case Type::Char:
+            return "Char";
+        case Type::Integer:
+            return "Int";
+        case Type::Long:
+            return "Long";
+        case Type::Float:
+            return "Float";
+        default:
+            Trace::internalError("SerializeGenerator::getPrimitiveTypeSuffix");
+            return "";
+    }
+}
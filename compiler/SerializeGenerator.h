@@ -0,0 +1,18 @@
+#ifndef SerializeGenerator_h
+#define SerializeGenerator_h
+
+#include "Definition.h"
+#include "Tree.h"
+
+class Expression;
+
+namespace SerializeGenerator {
+    void generate(ClassDefinition* classDef, Tree& tree);
+    void generateEmptySerializeMethods(ClassDefinition *classDef);
+    void generateWrite(Expression* value, Type* type, Tree& tree);
+    void generateRead(Expression* target, Type* type, Tree& tree);
+    Expression* generateRead(Type* type);
+    Identifier getPrimitiveTypeSuffix(const Type* type);
+}
+
+#endif
@@ -54,7 +54,8 @@ VariableDeclarationStatement::VariableDeclarationStatement(
     initExpression(e),
     isNameUnique(false),
     addToNameBindingsWhenTypeChecked(false),
-    hasLookedUpType(false) {}
+    hasLookedUpType(false),
+    stackAllocated(false) {}
 
 VariableDeclarationStatement::VariableDeclarationStatement(
     const VariableDeclarationStatement& other) :
@@ -66,7 +67,8 @@ VariableDeclarationStatement::VariableDeclarationStatement(
                                           nullptr),
     isNameUnique(other.isNameUnique),
     addToNameBindingsWhenTypeChecked(other.addToNameBindingsWhenTypeChecked),
-    hasLookedUpType(other.hasLookedUpType) {}
+    hasLookedUpType(other.hasLookedUpType),
+    stackAllocated(other.stackAllocated) {}
 
 VariableDeclarationStatement* VariableDeclarationStatement::create(
     const Identifier& i,
@@ -109,6 +109,17 @@ public:
         return addToNameBindingsWhenTypeChecked;
     }
 
+    // The variable is initialized with an object that does not outlive the
+    // method, so the object can be allocated on the stack. See
+    // EscapeAnalysis.
+    void setIsStackAllocated(bool s) {
+        stackAllocated = s;
+    }
+
+    bool isStackAllocated() const {
+        return stackAllocated;
+    }
+
 private:
     VariableDeclarationStatement(
         Type* t,
@@ -128,6 +139,7 @@ private:
     bool isNameUnique;
     bool addToNameBindingsWhenTypeChecked;
     bool hasLookedUpType;
+    bool stackAllocated;
 };
 
 using VariableDeclarationStatementList = std::vector<VariableDeclarationStatement*>;
@@ -5,8 +5,11 @@
 
 #include "Statement.h"
 #include "CloneGenerator.h"
+#include "SerializeGenerator.h"
 #include "Context.h"
 #include "Closure.h"
+#include "EscapeAnalysis.h"
+#include "RangeAnalysis.h"
 
 namespace {
     const Type* findRecursiveType(const TypeList& types) {
@@ -174,6 +177,64 @@ namespace {
         method.typeCheckAndTransform();
         return Traverse::Continue;
     }
+
+    class StackAllocationVisitor: public Visitor {
+    public:
+        StackAllocationVisitor();
+
+        Traverse::Result visitClass(ClassDefinition& classDefinition) override;
+        Traverse::Result visitMethod(MethodDefinition& method) override;
+    };
+
+    StackAllocationVisitor::StackAllocationVisitor() :
+        Visitor(TraverseClasses | TraverseMethods) {}
+
+    Traverse::Result StackAllocationVisitor::visitClass(
+        ClassDefinition& classDefinition) {
+
+        if (classDefinition.isGeneric()) {
+            // Don't traverse generic classes. They only act as templates for
+            // concrete classes.
+            return Traverse::Skip;
+        }
+        return Traverse::Continue;
+    }
+
+    Traverse::Result StackAllocationVisitor::visitMethod(
+        MethodDefinition& method) {
+
+        EscapeAnalysis::findStackAllocatedObjects(&method);
+        return Traverse::Continue;
+    }
+
+    class BoundsCheckVisitor: public Visitor {
+    public:
+        BoundsCheckVisitor();
+
+        Traverse::Result visitClass(ClassDefinition& classDefinition) override;
+        Traverse::Result visitMethod(MethodDefinition& method) override;
+    };
+
+    BoundsCheckVisitor::BoundsCheckVisitor() :
+        Visitor(TraverseClasses | TraverseMethods) {}
+
+    Traverse::Result BoundsCheckVisitor::visitClass(
+        ClassDefinition& classDefinition) {
+
+        if (classDefinition.isGeneric()) {
+            // Don't traverse generic classes. They only act as templates for
+            // concrete classes.
+            return Traverse::Skip;
+        }
+        return Traverse::Continue;
+    }
+
+    Traverse::Result BoundsCheckVisitor::visitMethod(
+        MethodDefinition& method) {
+
+        RangeAnalysis::findInBoundsSubscripts(&method);
+        return Traverse::Continue;
+    }
 }
 
 Tree* Tree::currentTree = nullptr;
@@ -286,6 +347,15 @@ void Tree::insertBuiltInTypesInGlobalNameBindings() {
     hashMethod->setIsVirtual(true);
     objectClass->appendMember(hashMethod);
 
+    // Add method:
+    // int _referenceCount()
+    auto referenceCountMethod =
+        MethodDefinition::create(BuiltInTypes::objectReferenceCountMethodName,
+                                 Type::create(Type::Integer),
+                                 false,
+                                 objectClass);
+    objectClass->appendMember(referenceCountMethod);
+
     // Create the primitive types (and some other types).
     auto viodClass = insertBuiltInType("void");
     insertBuiltInType("_");
@@ -305,6 +375,7 @@ void Tree::insertBuiltInTypesInGlobalNameBindings() {
         viodClass);
     equalsMethod->getReturnType()->setDefinition(boolClass);
     hashMethod->getReturnType()->setDefinition(intClass);
+    referenceCountMethod->getReturnType()->setDefinition(intClass);
 
     // Add equals() methods to the primitive types.
     addEqualsMethod(byteClass, Type::Byte);
@@ -439,6 +510,15 @@ void Tree::generateArrayClass() {
     sliceMethod->addArgument(Type::Integer, "end");
     addClassMember(sliceMethod);
 
+    // Add method:
+    // bool _isUnique()
+    auto isUniqueMethod =
+        MethodDefinition::create(CommonNames::isUniqueMethodName,
+                                 Type::create(Type::Boolean),
+                                 false,
+                                 arrayClass);
+    addClassMember(isUniqueMethod);
+
     // Add method:
     // each() (_)
     auto eachMethod =
@@ -588,6 +668,7 @@ ClassDefinition* Tree::startClass(
             // class to the derived class.
             newClass->generateEmptyCopyConstructor();
             CloneGenerator::generateEmptyCloneMethod(newClass);
+            SerializeGenerator::generateEmptySerializeMethods(newClass);
         }
     }
 
@@ -675,6 +756,20 @@ void Tree::typeCheckAndTransform() {
     traverse(visitor);
 }
 
+void Tree::findStackAllocatedObjects() {
+    currentPass = FindStackAllocatedObjects;
+
+    StackAllocationVisitor visitor;
+    traverse(visitor);
+}
+
+void Tree::eliminateBoundsChecks() {
+    currentPass = EliminateBoundsChecks;
+
+    BoundsCheckVisitor visitor;
+    traverse(visitor);
+}
+
 void Tree::traverse(Visitor& visitor) {
     for (definitionIter = globalDefinitions.begin();
          definitionIter != globalDefinitions.end();
@@ -1102,6 +1197,7 @@ void Tree::runPassesOnGeneratedClass(
         // Tree::startClass().
         generatedClass->generateEmptyCopyConstructor();
         CloneGenerator::generateEmptyCloneMethod(generatedClass);
+        SerializeGenerator::generateEmptySerializeMethods(generatedClass);
     }
 
     switch (currentPass) {
@@ -86,6 +86,8 @@ public:
     void convertClosureTypesInSigntures();
     void generateCloneMethods();
     void typeCheckAndTransform();
+    void findStackAllocatedObjects();
+    void eliminateBoundsChecks();
     void traverse(Visitor& visitor);
     void addClassMember(Definition* definition);
     void addClassDataMember(Type::BuiltInType type, const Identifier& name);
@@ -138,7 +140,9 @@ private:
         MakeGenericTypesConcrete,
         ConvertClosureTypes,
         GenerateCloneMethods,
-        TypeCheckAndTransform
+        TypeCheckAndTransform,
+        FindStackAllocatedObjects,
+        EliminateBoundsChecks
     };
 
     ClassDefinition* insertBuiltInType(const Identifier& name);
@@ -0,0 +1,328 @@
+#ifndef Allocator_h
+#define Allocator_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// The memory for objects and array elements that does not come from a region.
+// By default it comes from malloc(). A program that is built with
+// "bc -a slab" uses the slab allocator instead, which is compiled in by
+// defining BUHRLANG_SLAB_ALLOCATOR.
+//
+// The slab allocator serves small blocks from size classes. Each thread has
+// its own free list per size class, so allocating and freeing on the same
+// thread takes no lock and no atomic operation. The blocks of a size class
+// are carved out of slabs, which are aligned to their size so that the slab
+// of a block is found by masking the address. A block that is freed by
+// another thread than the one that allocated it, which is common since
+// messages are handed over between processes, goes back to the allocating
+// thread, which takes the blocks back when its own list runs dry. The freeing
+// thread collects such blocks in a batch per size class and hands over the
+// whole batch with one atomic operation, so that threads that free much of
+// each other's memory do not fight over the lists of the owner for every
+// block. Slabs are never given back to the system. When a thread ends, its
+// batches are handed over and its free lists are kept for the next thread
+// that starts.
+#ifdef BUHRLANG_SLAB_ALLOCATOR
+
+class SlabAllocator {
+public:
+    static void* allocate(size_t size) {
+        int sizeClass = getSizeClass(size);
+        if (sizeClass < 0) {
+            void* memory = malloc(size);
+            if (memory == nullptr) {
+                throw std::bad_alloc();
+            }
+            return memory;
+        }
+        ThreadCache* cache = getThreadCache();
+        if (cache == nullptr) {
+            return allocateAfterThreadEnd(sizeClass);
+        }
+        return cache->allocate(sizeClass);
+    }
+
+    static void deallocate(void* memory, size_t size) {
+        if (getSizeClass(size) < 0) {
+            free(memory);
+            return;
+        }
+        Block* block = static_cast<Block*>(memory);
+        Slab* slab = reinterpret_cast<Slab*>(
+            reinterpret_cast<uintptr_t>(memory) & ~(slabSize - 1));
+        ThreadCache* cache = getThreadCache();
+        if (slab->cache == cache) {
+            cache->push(slab->sizeClass, block);
+        } else if (cache != nullptr) {
+            cache->freeRemote(slab->cache, slab->sizeClass, block);
+        } else {
+            slab->cache->pushRemote(slab->sizeClass, block, block);
+        }
+    }
+
+private:
+    static const size_t slabSize = 64 * 1024;
+    static const int sizeClassCount = 16;
+
+    // The number of blocks of another thread that are collected before they
+    // are handed back.
+    static const int remoteBatchSize = 64;
+
+    struct Block {
+        Block* next;
+    };
+
+    class ThreadCache;
+
+    // Blocks that were freed by this thread but belong to the thread cache
+    // owner, linked from head to tail.
+    struct RemoteBatch {
+        ThreadCache* owner;
+        Block* head;
+        Block* tail;
+        int count;
+    };
+
+    struct Slab {
+        ThreadCache* cache;
+        int sizeClass;
+    };
+
+    // The header of a slab takes up the first block-aligned bytes.
+    static const size_t slabHeaderSize = 64;
+
+    class ThreadCache {
+    public:
+        ThreadCache() {
+            for (int i = 0; i < sizeClassCount; i++) {
+                freeLists[i] = nullptr;
+                remoteFrees[i].store(nullptr, std::memory_order_relaxed);
+                slabTops[i] = nullptr;
+                slabEnds[i] = nullptr;
+                remoteBatches[i].owner = nullptr;
+                remoteBatches[i].head = nullptr;
+                remoteBatches[i].tail = nullptr;
+                remoteBatches[i].count = 0;
+            }
+        }
+
+        void* allocate(int sizeClass) {
+            Block* block = freeLists[sizeClass];
+            if (block == nullptr) {
+                // Take back the blocks other threads have freed.
+                block = remoteFrees[sizeClass].exchange(
+                    nullptr,
+                    std::memory_order_acquire);
+            }
+            if (block != nullptr) {
+                freeLists[sizeClass] = block->next;
+                return block;
+            }
+            return carve(sizeClass);
+        }
+
+        void push(int sizeClass, Block* block) {
+            block->next = freeLists[sizeClass];
+            freeLists[sizeClass] = block;
+        }
+
+        // Add a block that belongs to another thread cache to the batch for
+        // that cache. The batch of a size class only holds blocks of one
+        // owner, so a block of another owner hands over the batch first.
+        void freeRemote(ThreadCache* owner, int sizeClass, Block* block) {
+            RemoteBatch& batch = remoteBatches[sizeClass];
+            if (batch.owner != owner) {
+                flushRemote(sizeClass);
+                batch.owner = owner;
+            }
+            if (batch.head == nullptr) {
+                batch.tail = block;
+            }
+            block->next = batch.head;
+            batch.head = block;
+            if (++batch.count == remoteBatchSize) {
+                flushRemote(sizeClass);
+            }
+        }
+
+        void flushRemote(int sizeClass) {
+            RemoteBatch& batch = remoteBatches[sizeClass];
+            if (batch.head != nullptr) {
+                batch.owner->pushRemote(sizeClass, batch.head, batch.tail);
+                batch.head = nullptr;
+                batch.tail = nullptr;
+                batch.count = 0;
+            }
+        }
+
+        void flushAllRemote() {
+            for (int i = 0; i < sizeClassCount; i++) {
+                flushRemote(i);
+            }
+        }
+
+        // Push the blocks from first to last, which are already linked, onto
+        // the list of blocks that other threads have freed.
+        void pushRemote(int sizeClass, Block* first, Block* last) {
+            Block* head = remoteFrees[sizeClass].load(std::memory_order_relaxed);
+            do {
+                last->next = head;
+            } while (!remoteFrees[sizeClass].compare_exchange_weak(
+                         head,
+                         first,
+                         std::memory_order_release,
+                         std::memory_order_relaxed));
+        }
+
+    private:
+        void* carve(int sizeClass) {
+            size_t blockSize = getBlockSize(sizeClass);
+            if (slabTops[sizeClass] + blockSize > slabEnds[sizeClass] ||
+                slabTops[sizeClass] == nullptr) {
+                void* memory = nullptr;
+                if (posix_memalign(&memory, slabSize, slabSize) != 0) {
+                    throw std::bad_alloc();
+                }
+                Slab* slab = static_cast<Slab*>(memory);
+                slab->cache = this;
+                slab->sizeClass = sizeClass;
+                slabTops[sizeClass] = static_cast<char*>(memory) +
+                                      slabHeaderSize;
+                slabEnds[sizeClass] = static_cast<char*>(memory) + slabSize;
+            }
+            void* block = slabTops[sizeClass];
+            slabTops[sizeClass] += blockSize;
+            return block;
+        }
+
+        Block* freeLists[sizeClassCount];
+        std::atomic<Block*> remoteFrees[sizeClassCount];
+        char* slabTops[sizeClassCount];
+        char* slabEnds[sizeClassCount];
+        RemoteBatch remoteBatches[sizeClassCount];
+    };
+
+    // Hands the cache of a thread back to the idle caches when the thread
+    // ends. The holder lets go of the cache before another thread can adopt
+    // it, and objects that are destroyed later in the exit of the thread are
+    // allocated and freed without a cache of their own.
+    class ThreadCacheHolder {
+    public:
+        ThreadCacheHolder() : cache(nullptr), ended(false) {}
+
+        ~ThreadCacheHolder() {
+            ThreadCache* idleCache = cache;
+            cache = nullptr;
+            ended = true;
+            if (idleCache != nullptr) {
+                idleCache->flushAllRemote();
+                std::lock_guard<std::mutex> lock(getIdleCacheMutex());
+                getIdleCaches().push_back(idleCache);
+            }
+        }
+
+        ThreadCache* cache;
+        bool ended;
+    };
+
+    // Size classes are 16 bytes apart up to 128 bytes, then 32 bytes apart up
+    // to 256 bytes, and then 64 bytes apart up to 512 bytes.
+    static int getSizeClass(size_t size) {
+        if (size <= 128) {
+            return size == 0 ? 0 : (size - 1) / 16;
+        } else if (size <= 256) {
+            return 8 + (size - 129) / 32;
+        } else if (size <= 512) {
+            return 12 + (size - 257) / 64;
+        }
+        return -1;
+    }
+
+    static size_t getBlockSize(int sizeClass) {
+        if (sizeClass < 8) {
+            return (sizeClass + 1) * 16;
+        } else if (sizeClass < 12) {
+            return 128 + (sizeClass - 7) * 32;
+        }
+        return 256 + (sizeClass - 11) * 64;
+    }
+
+    // Returns null once the thread has handed back its cache.
+    static ThreadCache* getThreadCache() {
+        static thread_local ThreadCacheHolder holder;
+        if (holder.cache == nullptr && !holder.ended) {
+            holder.cache = adoptCache();
+        }
+        return holder.cache;
+    }
+
+    // Allocate from an idle cache for a thread that has already handed back
+    // its own. The idle caches are only used under the lock.
+    static void* allocateAfterThreadEnd(int sizeClass) {
+        std::lock_guard<std::mutex> lock(getIdleCacheMutex());
+        std::vector<ThreadCache*>& idleCaches = getIdleCaches();
+        if (idleCaches.empty()) {
+            idleCaches.push_back(new ThreadCache());
+        }
+        return idleCaches.back()->allocate(sizeClass);
+    }
+
+    static ThreadCache* adoptCache() {
+        {
+            std::lock_guard<std::mutex> lock(getIdleCacheMutex());
+            std::vector<ThreadCache*>& idleCaches = getIdleCaches();
+            if (!idleCaches.empty()) {
+                ThreadCache* cache = idleCaches.back();
+                idleCaches.pop_back();
+                return cache;
+            }
+        }
+        return new ThreadCache();
+    }
+
+    // The idle caches are never deleted, since threads may end while the
+    // program shuts down.
+    static std::vector<ThreadCache*>& getIdleCaches() {
+        static std::vector<ThreadCache*>* idleCaches =
+            new std::vector<ThreadCache*>();
+        return *idleCaches;
+    }
+
+    static std::mutex& getIdleCacheMutex() {
+        static std::mutex* mutex = new std::mutex();
+        return *mutex;
+    }
+};
+
+#endif
+
+namespace Allocator {
+    inline void* allocate(size_t size) {
+#ifdef BUHRLANG_SLAB_ALLOCATOR
+        return SlabAllocator::allocate(size);
+#else
+        void* memory = malloc(size);
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+        return memory;
+#endif
+    }
+
+    inline void deallocate(void* memory, size_t size) {
+#ifdef BUHRLANG_SLAB_ALLOCATOR
+        SlabAllocator::deallocate(memory, size);
+#else
+        (void) size;
+        free(memory);
+#endif
+    }
+}
+
+#endif
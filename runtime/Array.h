@@ -1,17 +1,44 @@
 #ifndef Array_h
 #define Array_h
 
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Allocator.h"
 #include "Exception.h"
 
+template<class T>
+bool _isUniqueElement(const T&) {
+    return true;
+}
+
+template<class T>
+bool _isUniqueElement(const Pointer<T>& element) {
+    return element.get() == 0 || element->_isUnique();
+}
+
 template<class T>
 class Array: public object {
 public:
-    Array() : len(0), cap(5), elements(new T[cap]) {}
-    explicit Array(unsigned c) : len(0), cap(c), elements(new T[c]) {}
-    Array(T* e, unsigned l) : len(l), cap(l), elements(e) {}
+    Array() :
+        len(0),
+        cap(5),
+        elements(allocateElements(cap)),
+        isExternal(false) {}
+
+    explicit Array(unsigned c) :
+        len(0),
+        cap(c),
+        elements(allocateElements(c)),
+        isExternal(false) {}
+
+    // Takes over elements that were allocated with new[].
+    Array(T* e, unsigned l) : len(l), cap(l), elements(e), isExternal(true) {}
 
     ~Array() {
-        delete [] elements;
+        freeElements();
     }
 
     int length() const {
@@ -33,33 +60,69 @@ public:
         return elements[index];
     }
 
+    // Used by the compiler when it has found that the index is in bounds. An
+    // array never gets shorter, so an index that is below the length stays
+    // valid.
+    T& uncheckedAt(unsigned index) {
+        return elements[index];
+    }
+
     const T* data() const {
         return elements;
     }
 
-    void append(T element) {
+    // Return true if the array and all objects it contains are referenced
+    // exactly once.
+    bool _isUnique() const {
+        if (referenceCount != 1) {
+            return false;
+        }
+        for (unsigned i = 0; i < len; i++) {
+            if (!_isUniqueElement(elements[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void append(const T& element) {
         if (len == cap) {
-            reserve(cap * 2);
+            // The element may be one of the elements of this array, so it is
+            // copied before the elements are moved to the new storage.
+            T* newElements = allocateElements(grownCapacity());
+            new (newElements + len) T(element);
+            replaceElements(newElements, grownCapacity());
+        } else {
+            new (elements + len) T(element);
         }
-        elements[len++] = element;
+        len++;
     }
 
-    void appendAll(Pointer<Array<T> > array) {
-        unsigned combinedLength = len + array->len;
+    void append(T&& element) {
+        if (len == cap) {
+            reserve(grownCapacity());
+        }
+        new (elements + len) T(std::move(element));
+        len++;
+    }
+
+    void appendAll(const Pointer<Array<T> >& array) {
+        unsigned arrayLength = array->len;
+        unsigned combinedLength = len + arrayLength;
         if (combinedLength > cap) {
             reserve(combinedLength * 2);
         }
-        copy(elements + len, array->elements, array->len);
+        copyElements(elements + len, array->elements, arrayLength);
         len = combinedLength;
     }
 
-    Pointer<Array<T> > concat(Pointer<Array<T> > array) {
+    Pointer<Array<T> > concat(const Pointer<Array<T> >& array) {
         unsigned combinedLength = len + array->len;
-        T* combinedElements = new T[combinedLength];
-        copy(combinedElements, elements, len);
-        copy(combinedElements + len, array->elements, array->len);
-        return Pointer<Array<T> >(new Array<T>(combinedElements,
-                                               combinedLength));
+        Pointer<Array<T> > combined(new Array<T>(combinedLength));
+        copyElements(combined->elements, elements, len);
+        copyElements(combined->elements + len, array->elements, array->len);
+        combined->len = combinedLength;
+        return combined;
     }
 
     Pointer<Array<T> > slice(unsigned begin, unsigned end) {
@@ -67,30 +130,88 @@ public:
             throw IndexOutOfBoundsException();
         }
         unsigned sliceLength = end - begin + 1;
-        T* sliceElements = new T[sliceLength];
-        copy(sliceElements, elements + begin, sliceLength);
-        return Pointer<Array<T> >(new Array<T>(sliceElements, sliceLength));
+        Pointer<Array<T> > sliced(new Array<T>(sliceLength));
+        copyElements(sliced->elements, elements + begin, sliceLength);
+        sliced->len = sliceLength;
+        return sliced;
     }
 
 private:
+    unsigned grownCapacity() const {
+        return cap == 0 ? 5 : cap * 2;
+    }
+
     void reserve(unsigned newCapacity) {
+        replaceElements(allocateElements(newCapacity), newCapacity);
+    }
+
+    // Move the elements to new storage and free the old storage.
+    void replaceElements(T* newElements, unsigned newCapacity) {
+        moveElements(newElements, elements, len);
+        freeElements();
         cap = newCapacity;
-        T* newElements = new T[newCapacity];
-        copy(newElements, elements, len);
-        delete [] elements;
         elements = newElements;
+        isExternal = false;
+    }
+
+    // Only the first len elements are constructed. The rest of the storage is
+    // raw memory from the allocator, which may serve it from a slab of the
+    // current thread.
+    static T* allocateElements(unsigned count) {
+        if (count == 0) {
+            return nullptr;
+        }
+        return static_cast<T*>(Allocator::allocate(count * sizeof(T)));
+    }
+
+    void freeElements() {
+        if (isExternal) {
+            delete [] elements;
+        } else if (elements != nullptr) {
+            destroyElements(elements, len);
+            Allocator::deallocate(elements, cap * sizeof(T));
+        }
+    }
+
+    // Copy elements into raw storage. Elements of primitive type are copied
+    // with memcpy.
+    static void copyElements(T* destination, const T* source, unsigned count) {
+        if (std::is_trivially_copyable<T>::value) {
+            if (count != 0) {
+                memcpy(static_cast<void*>(destination), source,
+                       count * sizeof(T));
+            }
+            return;
+        }
+        for (unsigned i = 0; i < count; i++) {
+            new (destination + i) T(source[i]);
+        }
+    }
+
+    // Move elements into raw storage. Moving a Pointer leaves the reference
+    // count untouched.
+    static void moveElements(T* destination, T* source, unsigned count) {
+        if (std::is_trivially_copyable<T>::value) {
+            copyElements(destination, source, count);
+            return;
+        }
+        for (unsigned i = 0; i < count; i++) {
+            new (destination + i) T(std::move(source[i]));
+        }
     }
 
-    static void copy(T* destination, T* source, unsigned length) {
-        T* end = source + length;
-        while (source < end) {
-            *destination++ = *source++;
+    static void destroyElements(T* e, unsigned count) {
+        if (!std::is_trivially_destructible<T>::value) {
+            for (unsigned i = 0; i < count; i++) {
+                e[i].~T();
+            }
         }
     }
 
     unsigned len;
     unsigned cap;
     T* elements;
+    bool isExternal;
 };
 
 #endif
@@ -29,4 +29,16 @@ private:
     const char* info;
 };
 
+class SerializationException: public std::exception {
+public:
+    explicit SerializationException(const char* i) : info(i) {}
+
+    const char* what () const throw () {
+        return info;
+    }
+
+private:
+    const char* info;
+};
+
 #endif
@@ -7,7 +7,31 @@ public:
 
     virtual ~object() {}
 
-    virtual bool equals(Pointer<object> obj) {
+#ifdef BUHRLANG_REGION_ALLOCATOR
+    // Objects come from the region of the current process while it handles a
+    // message with region allocation turned on, and from the allocator
+    // otherwise.
+    static void* operator new(size_t size) {
+        return Region::allocateObject(size);
+    }
+
+    static void operator delete(void* memory) {
+        Region::deallocateObject(memory);
+    }
+#else
+    // Without region support, objects come straight from the allocator and
+    // carry no header. The destructor is virtual, so the size passed to
+    // delete is the size of the whole object.
+    static void* operator new(size_t size) {
+        return Allocator::allocate(size);
+    }
+
+    static void operator delete(void* memory, size_t size) {
+        Allocator::deallocate(memory, size);
+    }
+#endif
+
+    virtual bool equals(const Pointer<object>& obj) {
         return this == obj.get();
     }
 
@@ -15,6 +39,10 @@ public:
         return static_cast<int>(reinterpret_cast<long>(this));
     }
 
+    int _referenceCount() const {
+        return referenceCount;
+    }
+
     int referenceCount;
 };
 
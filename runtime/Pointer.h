@@ -1,12 +1,15 @@
 #ifndef Pointer_h
 #define Pointer_h
 
+#include <utility>
+#include <type_traits>
+
 #include "Exception.h"
 
 template<class T>
 class Pointer {
 public:
-    Pointer() : referenceCountPtr(0), ptr(0) {}
+    Pointer() : ptr(0), referenceCountPtr(0) {}
 
     Pointer(T* p) : ptr(p) {
         if (ptr) {
@@ -24,7 +27,11 @@ public:
         } 
     }
 
-    template<class U> 
+    // Only conversions from pointers to derived classes take part in overload
+    // resolution, so that a constructor taking a Pointer<T> is not ambiguous
+    // with one taking a pointer to an unrelated class.
+    template<class U, class = typename std::enable_if<
+        std::is_convertible<U*, T*>::value>::type>
     Pointer(const Pointer<U>& rhs) :
         ptr(rhs.get()),
         referenceCountPtr(rhs.referenceCountPtr) {
@@ -34,6 +41,26 @@ public:
         } 
     }
 
+    // Moving a pointer takes over the reference of the moved-from pointer, so
+    // the reference count is left untouched.
+    Pointer(Pointer&& rhs) :
+        ptr(rhs.ptr),
+        referenceCountPtr(rhs.referenceCountPtr) {
+
+        rhs.ptr = 0;
+        rhs.referenceCountPtr = 0;
+    }
+
+    template<class U, class = typename std::enable_if<
+        std::is_convertible<U*, T*>::value>::type>
+    Pointer(Pointer<U>&& rhs) :
+        ptr(rhs.ptr),
+        referenceCountPtr(rhs.referenceCountPtr) {
+
+        rhs.ptr = 0;
+        rhs.referenceCountPtr = 0;
+    }
+
     ~Pointer() {
         if (ptr && --(*referenceCountPtr) == 0) {
             delete ptr; 
@@ -45,6 +72,11 @@ public:
         return *this; 
     }
 
+    Pointer& operator=(Pointer&& rhs) {
+        Pointer(static_cast<Pointer&&>(rhs)).swap(*this);
+        return *this;
+    }
+
     Pointer& operator=(T* rhs) {
         Pointer(rhs).swap(*this); 
         return *this; 
@@ -99,9 +131,9 @@ public:
         (*referenceCountPtr)--;
     }   
 
-    int* referenceCountPtr;
-
 private:
+    template<class U> friend class Pointer;
+
     void swap(Pointer& rhs) {
         T* tmp = ptr; 
         ptr = rhs.ptr; 
@@ -112,6 +144,9 @@ private:
     }
 
     T* ptr;
+
+public:
+    int* referenceCountPtr;
 };
 
 template<class T, class U>
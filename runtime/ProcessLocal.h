@@ -0,0 +1,94 @@
+#ifndef ProcessLocal_h
+#define ProcessLocal_h
+
+#include <vector>
+#include <atomic>
+
+// Storage for the static data members of one process. Processes do not share
+// any data, so each process has its own copy of every static data member, no
+// matter which thread the process happens to run on.
+class ProcessLocalStorage {
+public:
+    ProcessLocalStorage() : slots() {}
+
+    ~ProcessLocalStorage() {
+        clear();
+    }
+
+    void* get(unsigned int index) const {
+        if (index < slots.size()) {
+            return slots[index].value;
+        }
+        return nullptr;
+    }
+
+    void set(unsigned int index, void* value, void (*destroy)(void*)) {
+        if (index >= slots.size()) {
+            slots.resize(index + 1);
+        }
+        slots[index].value = value;
+        slots[index].destroy = destroy;
+    }
+
+    void clear() {
+        for (auto& slot: slots) {
+            if (slot.value != nullptr) {
+                slot.destroy(slot.value);
+            }
+        }
+        slots.clear();
+    }
+
+    // The storage of the process that is currently running on this thread.
+    static ProcessLocalStorage*& current() {
+        static thread_local ProcessLocalStorage* storage = nullptr;
+        return storage;
+    }
+
+    static unsigned int allocateIndex() {
+        static std::atomic<unsigned int> indexCounter(0);
+        return indexCounter++;
+    }
+
+private:
+    struct Slot {
+        Slot() : value(nullptr), destroy(nullptr) {}
+
+        void* value;
+        void (*destroy)(void*);
+    };
+
+    std::vector<Slot> slots;
+};
+
+template<class T>
+class ProcessLocal {
+public:
+    ProcessLocal() :
+        index(ProcessLocalStorage::allocateIndex()),
+        initializer(nullptr) {}
+
+    explicit ProcessLocal(T (*init)()) :
+        index(ProcessLocalStorage::allocateIndex()),
+        initializer(init) {}
+
+    T& get() {
+        ProcessLocalStorage* storage = ProcessLocalStorage::current();
+        void* value = storage->get(index);
+        if (value == nullptr) {
+            value = initializer ? new T(initializer()) : new T();
+            storage->set(index, value, destroy);
+        }
+        return *static_cast<T*>(value);
+    }
+
+private:
+    static void destroy(void* value) {
+        delete static_cast<T*>(value);
+    }
+
+    unsigned int index;
+    T (*initializer)();
+};
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef Region_h
+#define Region_h
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#include "Allocator.h"
+
+// Memory for the objects that a process creates while it handles one message.
+// The objects are carved out of a chunk by bumping a pointer. Most of them
+// die before the handler returns, and if all of them have, the chunk is used
+// again from the start for the next message. An object that outlives the
+// message, because it was stored or sent, stays where it is. The chunk is then
+// filled up before a new one is started, and it is freed when its last object
+// is deleted, which may happen on any thread.
+//
+// A single object that outlives its message keeps its whole chunk, 64 KB,
+// from being freed. To bound that, a region that has let go of
+// maxPinnedChunks chunks that still had live objects in them stops handing
+// out memory, and the objects of its process come from the allocator from
+// then on. A process can therefore pin at most that many chunks plus the one
+// it is using.
+//
+// Regions are only compiled in when the program is built with "bc -r", which
+// defines BUHRLANG_REGION_ALLOCATOR. Objects then carry a 16-byte header that
+// tells where they came from. Without regions, objects carry no header.
+class Region {
+public:
+    Region() :
+        chunk(nullptr),
+        top(nullptr),
+        end(nullptr),
+        allocations(0),
+        pinnedChunks(0) {}
+
+    ~Region() {
+        retireChunk();
+    }
+
+    // Allocate memory for an object, or return null if the object is too big
+    // for a chunk or no chunk could be allocated.
+    void* allocate(size_t size) {
+        if (size > maxObjectSize) {
+            return nullptr;
+        }
+        if (top + size > end) {
+            retireChunk();
+            if (pinnedChunks >= maxPinnedChunks || !startChunk()) {
+                return nullptr;
+            }
+        }
+        void* memory = top;
+        top += size;
+        allocations++;
+        return memory;
+    }
+
+    // Called when the handler has returned. If every object allocated in the
+    // current chunk is gone, the chunk is used again from the start.
+    void reset() {
+        if (chunk != nullptr &&
+            chunk->liveCount.load(std::memory_order_acquire) ==
+                ownerBias - allocations) {
+            chunk->liveCount.store(ownerBias, std::memory_order_relaxed);
+            allocations = 0;
+            top = chunk->memory;
+        }
+    }
+
+    // The region that objects created on this thread are allocated from, or
+    // null if they are allocated on the heap.
+    static Region*& current() {
+        static thread_local Region* region = nullptr;
+        return region;
+    }
+
+    // Allocate memory for an object from the current region, or from the
+    // allocator. Each object is preceded by a header that tells where it came
+    // from.
+    static void* allocateObject(size_t size) {
+        size_t totalSize = roundUp(size) + sizeof(Header);
+        Region* region = current();
+        Chunk* owner = nullptr;
+        void* memory = nullptr;
+        if (region != nullptr) {
+            memory = region->allocate(totalSize);
+            owner = region->chunk;
+        }
+        if (memory == nullptr) {
+            memory = Allocator::allocate(totalSize);
+            owner = nullptr;
+        }
+        Header* header = static_cast<Header*>(memory);
+        header->chunk = owner;
+        header->size = totalSize;
+        return header + 1;
+    }
+
+    static void deallocateObject(void* object) {
+        if (object == nullptr) {
+            return;
+        }
+        Header* header = static_cast<Header*>(object) - 1;
+        if (header->chunk == nullptr) {
+            Allocator::deallocate(header, header->size);
+        } else {
+            release(header->chunk, 1);
+        }
+    }
+
+private:
+    static const size_t chunkSize = 64 * 1024;
+    static const size_t maxObjectSize = chunkSize / 8;
+    static const size_t alignment = 16;
+    static const int maxPinnedChunks = 16;
+
+    // While a chunk belongs to a region, its live count is this bias minus
+    // the number of objects that have been deleted. The region counts the
+    // objects it allocates itself, so allocating takes no atomic operation.
+    // Once the region lets go of the chunk, the bias is replaced by the
+    // number of allocated objects, which leaves the number of live objects.
+    static const long ownerBias = 1L << 40;
+
+    struct Chunk {
+        std::atomic<long> liveCount;
+        alignas(16) char memory[1];
+    };
+
+    struct alignas(16) Header {
+        Chunk* chunk;
+        size_t size;
+    };
+
+    static size_t roundUp(size_t size) {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool startChunk() {
+        void* memory = malloc(chunkSize);
+        if (memory == nullptr) {
+            return false;
+        }
+        chunk = new (memory) Chunk();
+        chunk->liveCount.store(ownerBias, std::memory_order_relaxed);
+        top = chunk->memory;
+        end = static_cast<char*>(memory) + chunkSize;
+        allocations = 0;
+        return true;
+    }
+
+    void retireChunk() {
+        if (chunk != nullptr) {
+            if (chunk->liveCount.load(std::memory_order_acquire) !=
+                ownerBias - allocations) {
+                pinnedChunks++;
+            }
+            release(chunk, ownerBias - allocations);
+            chunk = nullptr;
+            top = nullptr;
+            end = nullptr;
+        }
+    }
+
+    static void release(Chunk* chunk, long count) {
+        if (chunk->liveCount.fetch_sub(count, std::memory_order_acq_rel) ==
+            count) {
+            chunk->~Chunk();
+            free(chunk);
+        }
+    }
+
+    Chunk* chunk;
+    char* top;
+    char* end;
+    long allocations;
+
+    // The number of chunks that still had live objects when the region let
+    // go of them.
+    int pinnedChunks;
+};
+
+#endif
@@ -2,9 +2,11 @@
 #define Runtime_h
 
 #include "Pointer.h"
+#include "Region.h"
 #include "Object.h"
 #include "Array.h"
 #include "Defer.h"
+#include "ProcessLocal.h"
 
 #endif
 
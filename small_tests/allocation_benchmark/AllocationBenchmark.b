@@ -0,0 +1,59 @@
+import "Trace"
+import "Convert"
+
+// Allocation benchmark. Every worker builds and splits strings, which
+// allocates many small objects and arrays that die right away, and sends some
+// of them to a collector, which frees them on another thread. Build it once
+// with "bc -a slab" and once without, and run both with the time command and
+// different values of BUHRLANG_SCHEDULER and BUHRLANG_WORKERS to compare the
+// slab allocator with malloc.
+
+process Collector {
+    var int collected = 0
+
+    collect(string word) {
+        collected += word.length
+    }
+
+    int getCollected() {
+        return collected
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+process Worker {
+    run(int rounds, Collector collector) {
+        var int words = 0
+        for var int i = 0; i < rounds; i++ {
+            let line = "round " + Convert.toStr(i) + " of worker " +
+                       Convert.toStr(Process.getPid)
+            let tokens = line.split
+            words += tokens.length
+            if i % 16 == 0 {
+                collector.collect(tokens[3])
+            }
+        }
+        Process.terminate
+    }
+}
+
+main() {
+    let workerCount = 8
+    let rounds = 50000
+
+    let collector = new Collector
+    var workers = new Worker[]
+    for var int i = 0; i < workerCount; i++ {
+        let worker = new Worker
+        worker.run(rounds, collector)
+        workers.append(worker)
+    }
+    workers.each |worker| { worker.wait }
+
+    println(collector.getCollected)
+    collector.stop
+    collector.wait
+}
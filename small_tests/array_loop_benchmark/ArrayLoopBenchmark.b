@@ -0,0 +1,51 @@
+import "Trace"
+import "Convert"
+
+// Array loop benchmark. Counted loops index arrays with the loop variable,
+// and strings of equal length are compared character by character, which is
+// where bounds checks on every element access show. Run it with the time
+// command.
+
+int dotProduct(int[] a, int[] b) {
+    let length = a.length
+    if b.length < length {
+        return 0
+    }
+    var int sum = 0
+    for var int i = 0; i < length; i++ {
+        sum += a[i] * b[i]
+    }
+    return sum
+}
+
+int countEqual(string[] words, string word) {
+    var int count = 0
+    for var int i = 0; i < words.length; i++ {
+        if words[i].equals(word) {
+            count++
+        }
+    }
+    return count
+}
+
+main() {
+    var a = new int[]
+    var b = new int[]
+    for var int i = 0; i < 1000; i++ {
+        a.append(i % 7)
+        b.append(i % 5)
+    }
+
+    var words = new string[]
+    for var int i = 0; i < 100; i++ {
+        words.append("abcdefghijklmnopqrstuvwxyz" + Convert.toStr(i % 10))
+    }
+    let word = "abcdefghijklmnopqrstuvwxyz3"
+
+    var int total = 0
+    for var int round = 0; round < 50000; round++ {
+        total += dotProduct(a, b)
+        total += countEqual(words, word)
+    }
+    println(Convert.toStr(total))
+}
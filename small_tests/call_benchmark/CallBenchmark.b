@@ -0,0 +1,70 @@
+import "Trace"
+import "Convert"
+
+// Method call benchmark. Objects and strings are passed down a chain of small
+// methods, which is where the cost of updating reference counts on every
+// call shows. Run it with the time command.
+
+class Vector2 {
+    var int x
+    var int y
+
+    init(int x, int y) {
+        this.x = x
+        this.y = y
+    }
+}
+
+class Accumulator {
+    var int total = 0
+    var Vector2 last = new Vector2(0, 0)
+
+    add(Vector2 vector, string label) {
+        total += length(vector) + label.length
+        remember(vector)
+    }
+
+    int length(Vector2 vector) {
+        return abs(vector.x) + abs(vector.y)
+    }
+
+    int abs(int value) {
+        if value < 0 {
+            return -value
+        }
+        return value
+    }
+
+    remember(Vector2 vector) {
+        if vector.x > last.x {
+            last = vector
+        }
+    }
+
+    addLast(string label) {
+        add(last, label)
+    }
+}
+
+int sum(Vector2[] vectors, Accumulator accumulator, string label) {
+    for var int i = 0; i < vectors.length; i++ {
+        accumulator.add(vectors[i], label)
+    }
+    accumulator.addLast(label)
+    return accumulator.total
+}
+
+main() {
+    var vectors = new Vector2[]
+    for var int i = 0; i < 1000; i++ {
+        vectors.append(new Vector2(i, -i))
+    }
+
+    let accumulator = new Accumulator
+    let label = "vector"
+    var int total = 0
+    for var int round = 0; round < 20000; round++ {
+        total = sum(vectors, accumulator, label)
+    }
+    println(Convert.toStr(total))
+}
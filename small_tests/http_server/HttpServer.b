@@ -2,6 +2,7 @@ import "Convert"
 import "TcpSocket"
 import "File"
 import "Trace"
+import "ProcessPool"
 
 class HttpRequest(string method, string url) {
     static Option<HttpRequest> receive(TcpSocket socket) {
@@ -38,7 +39,6 @@ process HttpWorker {
             None               -> new HttpResponse("400", "Bad Request")
         }
         socket.write(response.encode)
-        Process.terminate
     }
 
 private:
@@ -69,9 +69,9 @@ private:
 main() {
     println("Listening on port 8080...")
     let listenerSocket = TcpSocket.createListener(8080)
+    let workers = new ProcessPool<HttpWorker>(4, 64)
     while {
         let acceptedSocket = listenerSocket.accept
-        let worker = new HttpWorker
-        worker.handleConnection(acceptedSocket)
+        workers.get.handleConnection(acceptedSocket)
     }
 }
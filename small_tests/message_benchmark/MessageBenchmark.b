@@ -0,0 +1,57 @@
+import "Trace"
+import "Convert"
+
+// Many-to-many messaging benchmark. Every client calls every server in turn,
+// so all processes send and receive at the same time. Run it with the time
+// command and different values of BUHRLANG_SCHEDULER and BUHRLANG_WORKERS to
+// see how message passing scales with the number of cores.
+
+process Server {
+    int call(int value) {
+        return value + 1
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+Server getServer(int index) {
+    return new Server named "Server" + Convert.toStr(index)
+}
+
+process Client {
+    run(int serverCount, int rounds) {
+        var servers = new Server[]
+        for var int i = 0; i < serverCount; i++ {
+            servers.append(getServer(i))
+        }
+        var int sum = 0
+        for var int i = 0; i < rounds; i++ {
+            servers.each |server| { sum = server.call(sum) }
+        }
+        Process.terminate
+    }
+}
+
+main() {
+    let processCount = 8
+    let rounds = 5000
+
+    var servers = new Server[]
+    for var int i = 0; i < processCount; i++ {
+        servers.append(getServer(i))
+    }
+
+    var clients = new Client[]
+    for var int i = 0; i < processCount; i++ {
+        let client = new Client
+        client.run(processCount, rounds)
+        clients.append(client)
+    }
+    clients.each |client| { client.wait }
+
+    servers.each |server| { server.stop }
+    servers.each |server| { server.wait }
+    println(processCount * processCount * rounds)
+}
@@ -0,0 +1,22 @@
+// A process that is spawned by EchoServer and called by EchoClient, which runs
+// in another executable.
+process Echo {
+    var int calls
+
+    string echo(string text) {
+        calls++
+        return text
+    }
+
+    int add(int a, int b) {
+        calls++
+        return a + b
+    }
+
+    // Terminate once the result has been sent, and return the number of calls
+    // handled before.
+    int stop() {
+        Process.terminate
+        return calls
+    }
+}
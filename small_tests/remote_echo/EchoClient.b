@@ -0,0 +1,37 @@
+import "Echo"
+import "Trace"
+
+main() {
+    let pid = Process.connect("/tmp/buhrlang_echo.sock", "Echo")
+    if pid == 0 {
+        println("Could not connect. Is EchoServer running?")
+        return
+    }
+    let echo = (Echo) new Echo_Proxy(pid)
+    println(echo.echo("Hello from node " + Convert.toStr(Process.getNode)))
+
+    var sum = 0
+    var i = 0
+    while i < 1000 {
+        sum = sum + echo.add(i, 1)
+        i++
+    }
+    println("Sum: " + Convert.toStr(sum))
+
+    // Asynchronous calls are batched on the connection.
+    var futures = new Future<int>[10]
+    i = 0
+    while i < 10 {
+        futures.append(echo.addAsync(i, i))
+        i++
+    }
+    sum = 0
+    i = 0
+    while i < 10 {
+        sum = sum + futures[i].await
+        i++
+    }
+    println("Async sum: " + Convert.toStr(sum))
+
+    println("Echo handled " + Convert.toStr(echo.stop) + " calls")
+}
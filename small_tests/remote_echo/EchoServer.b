@@ -0,0 +1,18 @@
+import "Echo"
+import "Trace"
+
+// Run with a node ID, and then run EchoClient with another node ID:
+//
+//     BUHRLANG_NODE=1 ./EchoServer &
+//     BUHRLANG_NODE=2 ./EchoClient
+//
+main() {
+    let echo = new Echo named "Echo"
+    if !Process.listen("/tmp/buhrlang_echo.sock") {
+        println("Could not listen. Is BUHRLANG_NODE set?")
+        return
+    }
+    println("Node " + Convert.toStr(Process.getNode) + " is listening")
+    echo.wait
+    println("Echo has stopped")
+}
@@ -0,0 +1,26 @@
+import "Trace"
+import "Convert"
+
+// String benchmark. Header-like lines are built, split into short tokens and
+// compared, and all tokens are kept alive, which is where the memory and the
+// number of allocations per string show. Run it with the time command.
+
+main() {
+    var tokens = new string[]
+    let wanted = "value3"
+    var int matches = 0
+    for var int round = 0; round < 100000; round++ {
+        var line = "Host: name"
+        line.append(" key" + Convert.toStr(round % 100))
+        line.append(" value" + Convert.toStr(round % 10))
+        let words = line.split()
+        for var int i = 0; i < words.length; i++ {
+            if words[i].equals(wanted) {
+                matches++
+            }
+            tokens.append(words[i])
+        }
+    }
+    println(Convert.toStr(tokens.length) + " tokens, " +
+            Convert.toStr(matches) + " matches")
+}
@@ -0,0 +1,61 @@
+// A buffer of bytes that message objects are serialized to and deserialized
+// from. The compiler generates a _serialize() method and a deserializing
+// constructor for every message class, and a _serialize() and _deserialize()
+// method for every message enum, that write and read the data members to and
+// from a byte buffer. Values are read back in the order they were written.
+// Values are stored in the byte order of the machine, so the bytes can be
+// exchanged between processes on the same machine.
+native class ByteBuffer {
+
+    // Create an empty buffer to write to.
+    init()
+
+    // Create a buffer that reads the given bytes.
+    init(byte[] bytes)
+
+    // Write a value of primitive type.
+    writeBool(bool value)
+    writeByte(byte value)
+    writeChar(char value)
+    writeInt(int value)
+    writeLong(long value)
+    writeFloat(float value)
+
+    // Write an array of primitive type, or null, as one block of bytes.
+    writeBoolArray(bool[] values)
+    writeByteArray(byte[] values)
+    writeCharArray(char[] values)
+    writeIntArray(int[] values)
+    writeLongArray(long[] values)
+    writeFloatArray(float[] values)
+
+    // Read a value of primitive type.
+    bool readBool()
+    byte readByte()
+    char readChar()
+    int readInt()
+    long readLong()
+    float readFloat()
+
+    // Read an array of primitive type, or null.
+    bool[] readBoolArray()
+    byte[] readByteArray()
+    char[] readCharArray()
+    int[] readIntArray()
+    long[] readLongArray()
+    float[] readFloatArray()
+
+    // Read a message object that was written by its _serialize() method, or
+    // null. The type of the object is identified by a type tag that the
+    // _serialize() method writes first.
+    object readObject()
+
+    // Return the bytes written so far.
+    byte[] toBytes()
+
+    // Return the number of bytes in the buffer.
+    int length()
+
+    // Return true if all bytes in the buffer have been read.
+    bool atEnd()
+}
@@ -0,0 +1,264 @@
+#include "ByteBuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace {
+    // Written in place of an array that is null.
+    const int nullArrayLength = -1;
+
+    // Written in place of an object that is null. Type tags are never zero.
+    const int nullObjectTag = 0;
+
+    struct RegisteredType {
+        std::string name;
+        ByteBuffer::Deserializer deserializer;
+    };
+
+    typedef std::map<int, RegisteredType> TypeRegistry;
+
+    // The registry is filled during static initialization, so it is created
+    // on first use to not depend on the order in which modules are
+    // initialized.
+    TypeRegistry& getTypeRegistry() {
+        static TypeRegistry registry;
+        return registry;
+    }
+
+    std::mutex& getTypeRegistryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+}
+
+ByteBuffer::ByteBuffer() : bytes(), readPosition(0) {}
+
+ByteBuffer::ByteBuffer(Pointer<Array<unsigned char> > b) :
+    bytes(b->data(), b->data() + b->length()),
+    readPosition(0) {}
+
+ByteBuffer::ByteBuffer(const void* b, size_t length) :
+    bytes(static_cast<const unsigned char*>(b),
+          static_cast<const unsigned char*>(b) + length),
+    readPosition(0) {}
+
+void ByteBuffer::writeBool(bool value) {
+    write(&value, sizeof value);
+}
+
+void ByteBuffer::writeByte(unsigned char value) {
+    bytes.push_back(value);
+}
+
+void ByteBuffer::writeChar(char value) {
+    write(&value, sizeof value);
+}
+
+void ByteBuffer::writeInt(int value) {
+    write(&value, sizeof value);
+}
+
+void ByteBuffer::writeLong(long long value) {
+    write(&value, sizeof value);
+}
+
+void ByteBuffer::writeFloat(float value) {
+    write(&value, sizeof value);
+}
+
+void ByteBuffer::writeBoolArray(Pointer<Array<bool> > values) {
+    writeArray(values);
+}
+
+void ByteBuffer::writeByteArray(Pointer<Array<unsigned char> > values) {
+    writeArray(values);
+}
+
+void ByteBuffer::writeCharArray(Pointer<Array<char> > values) {
+    writeArray(values);
+}
+
+void ByteBuffer::writeIntArray(Pointer<Array<int> > values) {
+    writeArray(values);
+}
+
+void ByteBuffer::writeLongArray(Pointer<Array<long long> > values) {
+    writeArray(values);
+}
+
+void ByteBuffer::writeFloatArray(Pointer<Array<float> > values) {
+    writeArray(values);
+}
+
+bool ByteBuffer::readBool() {
+    bool value;
+    read(&value, sizeof value);
+    return value;
+}
+
+unsigned char ByteBuffer::readByte() {
+    unsigned char value;
+    read(&value, sizeof value);
+    return value;
+}
+
+char ByteBuffer::readChar() {
+    char value;
+    read(&value, sizeof value);
+    return value;
+}
+
+int ByteBuffer::readInt() {
+    int value;
+    read(&value, sizeof value);
+    return value;
+}
+
+long long ByteBuffer::readLong() {
+    long long value;
+    read(&value, sizeof value);
+    return value;
+}
+
+float ByteBuffer::readFloat() {
+    float value;
+    read(&value, sizeof value);
+    return value;
+}
+
+Pointer<Array<bool> > ByteBuffer::readBoolArray() {
+    return readArray<bool>();
+}
+
+Pointer<Array<unsigned char> > ByteBuffer::readByteArray() {
+    return readArray<unsigned char>();
+}
+
+Pointer<Array<char> > ByteBuffer::readCharArray() {
+    return readArray<char>();
+}
+
+Pointer<Array<int> > ByteBuffer::readIntArray() {
+    return readArray<int>();
+}
+
+Pointer<Array<long long> > ByteBuffer::readLongArray() {
+    return readArray<long long>();
+}
+
+Pointer<Array<float> > ByteBuffer::readFloatArray() {
+    return readArray<float>();
+}
+
+Pointer<object> ByteBuffer::readObject() {
+    int tag = readInt();
+    if (tag == nullObjectTag) {
+        return Pointer<object>();
+    }
+
+    Deserializer deserializer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(getTypeRegistryMutex());
+        TypeRegistry& registry = getTypeRegistry();
+        auto i = registry.find(tag);
+        if (i != registry.end()) {
+            deserializer = i->second.deserializer;
+        }
+    }
+    if (deserializer == nullptr) {
+        throw SerializationException("ByteBuffer.readObject(): unknown type");
+    }
+    return deserializer(Pointer<ByteBuffer>(this));
+}
+
+Pointer<Array<unsigned char> > ByteBuffer::toBytes() {
+    if (bytes.empty()) {
+        return Pointer<Array<unsigned char> >(new Array<unsigned char>());
+    }
+    unsigned char* copy = new unsigned char[bytes.size()];
+    memcpy(copy, bytes.data(), bytes.size());
+    return Pointer<Array<unsigned char> >(
+        new Array<unsigned char>(copy, bytes.size()));
+}
+
+int ByteBuffer::length() {
+    return bytes.size();
+}
+
+bool ByteBuffer::atEnd() {
+    return readPosition == bytes.size();
+}
+
+bool ByteBuffer::registerType(
+    int tag,
+    const char* name,
+    Deserializer deserializer) {
+
+    std::lock_guard<std::mutex> lock(getTypeRegistryMutex());
+    TypeRegistry& registry = getTypeRegistry();
+    auto i = registry.find(tag);
+    if (i != registry.end()) {
+        if (i->second.name != name) {
+            fprintf(stderr,
+                    "Message types %s and %s have the same type tag.\n",
+                    i->second.name.c_str(),
+                    name);
+            abort();
+        }
+        return true;
+    }
+
+    RegisteredType type;
+    type.name = name;
+    type.deserializer = deserializer;
+    registry[tag] = type;
+    return true;
+}
+
+void ByteBuffer::write(const void* value, size_t size) {
+    auto valueBytes = static_cast<const unsigned char*>(value);
+    bytes.insert(bytes.end(), valueBytes, valueBytes + size);
+}
+
+void ByteBuffer::read(void* value, size_t size) {
+    if (size > bytes.size() - readPosition) {
+        throw SerializationException("ByteBuffer: read past the end");
+    }
+    memcpy(value, bytes.data() + readPosition, size);
+    readPosition += size;
+}
+
+template<class T>
+void ByteBuffer::writeArray(const Pointer<Array<T> >& values) {
+    if (values.get() == nullptr) {
+        writeInt(nullArrayLength);
+        return;
+    }
+    int length = values->length();
+    writeInt(length);
+    write(values->data(), length * sizeof(T));
+}
+
+template<class T>
+Pointer<Array<T> > ByteBuffer::readArray() {
+    int length = readInt();
+    if (length == nullArrayLength) {
+        return Pointer<Array<T> >();
+    }
+    if (length < 0 ||
+        static_cast<size_t>(length) >
+            (bytes.size() - readPosition) / sizeof(T)) {
+        throw SerializationException("ByteBuffer: read past the end");
+    }
+    if (length == 0) {
+        // An array that owns no elements could not grow.
+        return Pointer<Array<T> >(new Array<T>());
+    }
+    T* elements = new T[length];
+    read(elements, length * sizeof(T));
+    return Pointer<Array<T> >(new Array<T>(elements, length));
+}
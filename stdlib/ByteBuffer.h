@@ -0,0 +1,79 @@
+#ifndef ByteBuffer_h
+#define ByteBuffer_h
+
+#include <vector>
+#include <stddef.h>
+#include <Runtime.h>
+
+class ByteBuffer: public object {
+public:
+    // Creates a message object of one type from the buffer.
+    typedef Pointer<object> (*Deserializer)(const Pointer<ByteBuffer>& buffer);
+
+    ByteBuffer();
+    explicit ByteBuffer(Pointer<Array<unsigned char> > bytes);
+    ByteBuffer(const void* bytes, size_t length);
+
+    void writeBool(bool value);
+    void writeByte(unsigned char value);
+    void writeChar(char value);
+    void writeInt(int value);
+    void writeLong(long long value);
+    void writeFloat(float value);
+
+    void writeBoolArray(Pointer<Array<bool> > values);
+    void writeByteArray(Pointer<Array<unsigned char> > values);
+    void writeCharArray(Pointer<Array<char> > values);
+    void writeIntArray(Pointer<Array<int> > values);
+    void writeLongArray(Pointer<Array<long long> > values);
+    void writeFloatArray(Pointer<Array<float> > values);
+
+    bool readBool();
+    unsigned char readByte();
+    char readChar();
+    int readInt();
+    long long readLong();
+    float readFloat();
+
+    Pointer<Array<bool> > readBoolArray();
+    Pointer<Array<unsigned char> > readByteArray();
+    Pointer<Array<char> > readCharArray();
+    Pointer<Array<int> > readIntArray();
+    Pointer<Array<long long> > readLongArray();
+    Pointer<Array<float> > readFloatArray();
+
+    Pointer<object> readObject();
+
+    Pointer<Array<unsigned char> > toBytes();
+    int length();
+    bool atEnd();
+
+    const std::vector<unsigned char>& getBytes() const {
+        return bytes;
+    }
+
+    // Register the deserializer of a message type under the type tag that its
+    // _serialize() method writes. The generated code of every message class
+    // registers itself during static initialization. Registering two types
+    // under the same tag aborts the program, since their objects could not be
+    // told apart.
+    static bool registerType(
+        int tag,
+        const char* name,
+        Deserializer deserializer);
+
+private:
+    void write(const void* value, size_t size);
+    void read(void* value, size_t size);
+
+    template<class T>
+    void writeArray(const Pointer<Array<T> >& values);
+
+    template<class T>
+    Pointer<Array<T> > readArray();
+
+    std::vector<unsigned char> bytes;
+    size_t readPosition;
+};
+
+#endif
@@ -15,12 +15,21 @@ Pointer<object> FileHandle::_clone() {
     return new FileHandle(*this);
 }
 
+bool FileHandle::_isUnique() {
+    return referenceCount == 1;
+}
+
+void FileHandle::_serialize(const Pointer<ByteBuffer>&) {
+    // A file stream is only valid in the OS process that opened it.
+    throw SerializationException("FileHandle cannot be serialized");
+}
+
 Pointer<FileHandle> CStandardIo::fopen(
     Pointer<string> filename,
     Pointer<string> mode) {
 
-    std::string fname(filename->buf->data(), filename->buf->length());
-    std::string fmode(mode->buf->data(), mode->buf->length());
+    std::string fname(filename->data(), filename->length());
+    std::string fmode(mode->data(), mode->length());
 
     FILE* file = ::fopen(fname.c_str(), fmode.c_str());
     if (file == NULL) {
@@ -36,7 +45,7 @@ Pointer<FileHandle> CStandardIo::fdopen(
     int fileDescriptor,
     Pointer<string> mode) {
 
-    std::string fmode(mode->buf->data(), mode->buf->length());
+    std::string fmode(mode->data(), mode->length());
 
     FILE* file = ::fdopen(fileDescriptor, fmode.c_str());
     if (file == NULL) {
@@ -57,7 +66,7 @@ void CStandardIo::fflush(Pointer<FileHandle> fileHandle) {
 }
 
 void CStandardIo::fputs(Pointer<string> str, Pointer<FileHandle> fileHandle) {
-    std::string data(str->buf->data(), str->buf->length());
+    std::string data(str->data(), str->length());
     ::fputs(data.c_str(), fileHandle->file);
 }
 
@@ -78,8 +87,8 @@ Pointer<string> CStandardIo::fgets(Pointer<FileHandle> fileHandle) {
 }
 
 void CStandardIo::fwrite(Pointer<string> buf, Pointer<FileHandle> fileHandle) {
-    size_t bufSize = buf->buf->length();
-    if (::fwrite(buf->buf->data(), 1, bufSize, fileHandle->file) != bufSize) {
+    size_t bufSize = buf->length();
+    if (::fwrite(buf->data(), 1, bufSize, fileHandle->file) != bufSize) {
         throw IoException("CStandardIo.fwrite()");
     }
 }
@@ -88,15 +97,11 @@ Pointer<string> CStandardIo::fread(
     int numBytes,
     Pointer<FileHandle> fileHandle) {
 
-    char* buf = new char[numBytes];
-    size_t numBytesRead = ::fread(buf, 1, numBytes, fileHandle->file);
-    if (numBytesRead < numBytes) {
-        char* oldBuf = buf;
-        buf = new char[numBytesRead];
-        memcpy(buf, oldBuf, numBytesRead);
-        delete[] oldBuf;
-    }
-    return Utils::makeStringNoCopy(buf, numBytesRead);
+    Pointer<string> str = string::withCapacity(numBytes);
+    size_t numBytesRead =
+        ::fread(str->mutableData(), 1, numBytes, fileHandle->file);
+    str->setLength(numBytesRead);
+    return str;
 }
 
 int CStandardIo::fileSize(Pointer<FileHandle> fileHandle) {
@@ -113,7 +118,7 @@ int CStandardIo::fileSize(Pointer<FileHandle> fileHandle) {
 }
 
 bool CStandardIo::fileExists(Pointer<string> filename) {
-    std::string fname(filename->buf->data(), filename->buf->length());
+    std::string fname(filename->data(), filename->length());
     return ::access(fname.c_str(), F_OK) != -1;
 }
 
@@ -9,6 +9,8 @@
 class FileHandle: public virtual object, public _Cloneable {
 public:
     virtual Pointer<object> _clone();
+    virtual bool _isUnique();
+    virtual void _serialize(const Pointer<ByteBuffer>& buffer);
 
     FILE* file;
 };
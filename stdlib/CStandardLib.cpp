@@ -31,7 +31,7 @@ Pointer<string> CStandardLib::toString(unsigned char b) {
 }
 
 int CStandardLib::toInt(Pointer<string> s) {
-    std::string str(s->buf->data(), s->buf->length());
+    std::string str(s->data(), s->length());
     int i;
 
     if (sscanf(str.c_str(), "%d", &i) == EOF) {
@@ -42,7 +42,7 @@ int CStandardLib::toInt(Pointer<string> s) {
 }
 
 int CStandardLib::toFloat(Pointer<string> s) {
-    std::string str(s->buf->data(), s->buf->length());
+    std::string str(s->data(), s->length());
     float f;
 
     if (sscanf(str.c_str(), "%f", &f) == EOF) {
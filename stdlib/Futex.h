@@ -0,0 +1,70 @@
+#ifndef Futex_h
+#define Futex_h
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <atomic>
+
+// Waiting for other threads. A thread that has nothing to do either spins for
+// a while, pausing between looks, or sleeps on an int until another thread
+// changes the int and wakes it up.
+namespace ProcessRuntime {
+    inline void spinPause() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    inline void futexWait(std::atomic<int>* address, int expectedValue) {
+        syscall(SYS_futex,
+                reinterpret_cast<int*>(address),
+                FUTEX_WAIT_PRIVATE,
+                expectedValue,
+                nullptr,
+                nullptr,
+                0);
+    }
+
+    inline void futexWake(std::atomic<int>* address) {
+        syscall(SYS_futex,
+                reinterpret_cast<int*>(address),
+                FUTEX_WAKE_PRIVATE,
+                1,
+                nullptr,
+                nullptr,
+                0);
+    }
+
+    // Like futexWait() and futexWake(), but for a futex word in memory that is
+    // shared with other OS processes.
+    inline void sharedFutexWait(
+        std::atomic<int>* address,
+        int expectedValue,
+        int timeoutMilliseconds) {
+
+        timespec timeout;
+        timeout.tv_sec = timeoutMilliseconds / 1000;
+        timeout.tv_nsec = (timeoutMilliseconds % 1000) * 1000000L;
+        syscall(SYS_futex,
+                reinterpret_cast<int*>(address),
+                FUTEX_WAIT,
+                expectedValue,
+                &timeout,
+                nullptr,
+                0);
+    }
+
+    inline void sharedFutexWake(std::atomic<int>* address) {
+        syscall(SYS_futex,
+                reinterpret_cast<int*>(address),
+                FUTEX_WAKE,
+                1,
+                nullptr,
+                nullptr,
+                0);
+    }
+}
+
+#endif
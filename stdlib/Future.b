@@ -0,0 +1,84 @@
+import "Process"
+
+// The result of a remote method call that may not have arrived yet. The
+// process proxies return futures from the asynchronous variants of the remote
+// methods, which are named after the remote method followed by "Async". Since
+// the caller does not block when sending the call, it can have any number of
+// calls in flight at the same time.
+class Future<T> {
+
+    // Create a future for the method call message of the given ID. The unpack
+    // function extracts the return value from the method result message.
+    init(int id, fun T(Message) unpack) {
+        messageId = id
+        unpackResult = unpack
+    }
+
+    // Create a future whose result is already known.
+    init(T value) {
+        result = value
+        hasResult = true
+    }
+
+    // Block until the result has arrived, and return it.
+    T await() {
+        if !hasResult {
+            result = unpackResult(Process.receiveMethodResult(messageId))
+            hasResult = true
+        }
+        return result
+    }
+
+    // Return true if the result has arrived. Never blocks.
+    bool poll() {
+        return hasResult || Process.hasMethodResult(messageId)
+    }
+
+    // Return true if the result has arrived, waiting for it at most the given
+    // number of milliseconds.
+    bool poll(int timeoutMilliseconds) {
+        return hasResult ||
+               Process.waitForMethodResult(messageId, timeoutMilliseconds)
+    }
+
+private:
+    var int messageId
+    var fun T(Message) unpackResult
+    var T result
+    var bool hasResult = false
+}
+
+// A number of futures of the same type that are waited for together.
+class FutureGroup<T> {
+
+    // Add a future to the group.
+    add(Future<T> future) {
+        futures.append(future)
+    }
+
+    // Return true if the results of all futures in the group have arrived.
+    // Never blocks.
+    bool poll() {
+        for var i = 0; i < futures.length; i++ {
+            if !futures[i].poll {
+                return false
+            }
+        }
+        return true
+    }
+
+    // Block until the results of all futures in the group have arrived, and
+    // return them in the order the futures were added. Results that arrive
+    // out of order are kept aside until they are asked for, so waiting for
+    // them one by one is not slower than waiting for any of them.
+    T[] whenAll() {
+        var results = new T[futures.length]
+        futures.each |future| {
+            results.append(future.await)
+        }
+        return results
+    }
+
+private:
+    var futures = new Future<T>[]
+}
@@ -5,6 +5,49 @@ class MessageType {
     static int MethodResult    = 1
     static int Terminate       = 2
     static int ChildTerminated = 3
+
+    // Sent to a process by the runtime when a receive or a wait for a method
+    // result times out.
+    static int Timeout         = 4
+}
+
+// What happens to a method call that is sent to a process whose mailbox is
+// full.
+class MailboxOverflow {
+
+    // The sender waits until there is room in the mailbox.
+    static int Block      = 0
+
+    // The call is dropped. The sender is not told.
+    static int DropNewest = 1
+
+    // The call is added, and the oldest queued call is dropped instead when
+    // the receiving process gets its next message.
+    static int DropOldest = 2
+
+    // The call is not sent, and Process.send returns 0.
+    static int Fail       = 3
+}
+
+// Where the runtime runs a process that the current process spawns.
+class ProcessPlacement {
+
+    // Wherever the runtime sees fit.
+    static int Default    = 0
+
+    // On the given core.
+    static int Pinned     = 1
+
+    // On a core in the same NUMA node as the spawning process.
+    static int NearParent = 2
+
+    // Spread over the NUMA nodes, one node after the other.
+    static int Spread     = 3
+
+    // On the same worker as the spawning process, in the workers scheduling
+    // mode, so that calls between them switch directly from one process to
+    // the other. Same as NearParent otherwise.
+    static int WithParent = 4
 }
 
 message class Message {
@@ -24,6 +67,15 @@ message class Message {
     // Data carried by the message.
     var _Cloneable data
 
+    // Link to the next message in the mailbox of the receiving process. Only
+    // used by the runtime, so it is neither cloned nor serialized.
+    private var long _next
+
+    // Time when the message was added to the mailbox of the receiving
+    // process. Only used by the runtime, so it is neither cloned nor
+    // serialized.
+    private var long _enqueueTime
+
     // Create a message.
     init(int msgType) {
         type = msgType
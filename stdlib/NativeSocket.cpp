@@ -45,7 +45,7 @@ int NativeSocket::accept(int listenerSocketFd) {
 }
 
 bool NativeSocket::connect(int socketFd, Pointer<string> host, int port) {
-    std::string hostName(host->buf->data(), host->buf->length());
+    std::string hostName(host->data(), host->length());
     struct hostent* server = gethostbyname(hostName.c_str());
     if (server == nullptr) {
         throw IoException("NativeSocket.connect()");
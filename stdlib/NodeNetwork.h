@@ -0,0 +1,832 @@
+#ifndef NodeNetwork_h
+#define NodeNetwork_h
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Message.h>
+
+#include "ByteBuffer.h"
+#include "Exception.h"
+#include "Futex.h"
+
+namespace ProcessRuntime {
+    // The node ID of an executable is kept in the upper bits of the PIDs of
+    // its processes, so that a PID names the same process in every executable
+    // it is sent to. An executable without a node ID uses all bits for the
+    // process number, just like before there were nodes.
+    const int nodeIdShift = 24;
+    const int maxNodeId = 127;
+    const int localPidMask = (1 << nodeIdShift) - 1;
+
+    // Number of bytes a node link reads from its socket at a time.
+    const size_t nodeLinkReadSize = 64 * 1024;
+
+    // Number of connections from other executables that may wait to be
+    // accepted.
+    const int nodeListenBacklog = 16;
+
+    // Number of bytes in the shared memory ring that carries the messages in
+    // one direction between two executables. Must be a power of two.
+    const size_t sharedRingCapacity = 1 << 20;
+    const uint64_t sharedRingMask = sharedRingCapacity - 1;
+
+    // Number of times the reader of a shared memory ring polls an empty ring,
+    // or the writer polls a full ring, before it goes to sleep.
+    const int sharedRingSpinCount =
+        std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+
+    // Longest time the reader or writer of a shared memory ring sleeps before
+    // it checks whether the link has been closed.
+    const int sharedRingWaitMilliseconds = 100;
+
+    // A byte stream from one executable to another through shared memory.
+    // There is one writer and one reader. The indexes count the bytes written
+    // and read so far, so they only grow, and the ring is empty when they are
+    // equal. A reader or writer that has nothing to do sleeps on its futex
+    // word, and the other side wakes it when it has moved its index.
+    struct SharedRing {
+        alignas(64) std::atomic<uint64_t> writeIndex;
+        alignas(64) std::atomic<uint64_t> readIndex;
+        alignas(64) std::atomic<int> readerSleeping;
+        alignas(64) std::atomic<int> writerSleeping;
+        alignas(64) unsigned char data[sharedRingCapacity];
+    };
+
+    class NodeNetwork;
+
+    // A connection to another Buhrlang executable on the same machine. A
+    // message for a process in the other executable is serialized by the
+    // sender, and a reader thread deserializes the messages sent by the other
+    // executable and delivers them to the local processes.
+    //
+    // The connection starts as a Unix domain socket. If the executable that
+    // connected could create shared memory and send it over the socket, the
+    // messages are carried by a ring in the shared memory for each direction,
+    // and the socket only tells when the other executable is gone. Otherwise
+    // the messages are appended to the output of the link, and a writer
+    // thread writes all output that has piled up with one system call, so
+    // messages that are sent while the previous write is in progress go out
+    // together.
+    class NodeLink {
+    public:
+        NodeLink(
+            NodeNetwork& network,
+            int fd,
+            int peerNode,
+            SharedRing* outgoing,
+            SharedRing* incoming,
+            void* sharedMemory);
+        ~NodeLink();
+
+        void start(const std::shared_ptr<NodeLink>& self);
+        bool send(int destinationPid, Message& message);
+        void close();
+
+        int getPeerNode() const {
+            return peerNode;
+        }
+
+    private:
+        void runWriter();
+        void runReader();
+        void runRingReader();
+        bool writeToRing(const unsigned char* bytes, size_t length);
+        bool waitForRing(
+            std::atomic<uint64_t>& index,
+            uint64_t value,
+            std::atomic<int>& sleeping);
+        void wakeRingPeer(std::atomic<int>& sleeping);
+        bool deliverFrames(std::vector<unsigned char>& input);
+
+        NodeNetwork& network;
+        int socketFd;
+        int peerNode;
+        SharedRing* outgoingRing;
+        SharedRing* incomingRing;
+        void* sharedMemory;
+        std::mutex mutex;
+        std::mutex ringWriterMutex;
+        std::condition_variable condition;
+        std::vector<unsigned char> output;
+        std::atomic<bool> isClosed;
+    };
+
+    // The links to the other executables, or nodes, that this executable has
+    // connected to or has been connected to by. There is at most one link to
+    // each node, and messages to a process in another node are sent over the
+    // link to that node. Nodes are identified by the node ID that each
+    // executable gets from BUHRLANG_NODE.
+    class NodeNetwork {
+    public:
+        // Return the PID of the local process of the given name, or 0.
+        using FindProcessFunction = int (*)(const std::string& name);
+
+        // Add a message sent by a process in another executable to the
+        // mailbox of a local process.
+        using DeliverFunction =
+            bool (*)(int destinationPid, std::unique_ptr<Message> message);
+
+        NodeNetwork(
+            int nodeId,
+            FindProcessFunction findProcessFunction,
+            DeliverFunction deliverFunction);
+
+        bool listen(const std::string& socketPath);
+        int connect(
+            const std::string& socketPath,
+            const std::string& processName);
+        bool send(int destinationPid, Message& message);
+        void removeLink(const NodeLink* link);
+
+        bool deliver(int destinationPid, std::unique_ptr<Message> message) {
+            return deliverMessage(destinationPid, std::move(message));
+        }
+
+    private:
+        void acceptConnections(int listenerFd);
+        void acceptConnection(int fd);
+        void addLink(
+            int fd,
+            int peerNode,
+            void* sharedMemory,
+            bool isConnector);
+
+        int nodeId;
+        FindProcessFunction findProcess;
+        DeliverFunction deliverMessage;
+        std::mutex mutex;
+        std::map<int, std::shared_ptr<NodeLink>> links;
+    };
+
+    // Write all bytes to a socket. Returns false if the connection is gone.
+    inline bool writeFully(int fd, const unsigned char* bytes, size_t length) {
+        while (length > 0) {
+            ssize_t written = ::send(fd, bytes, length, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            length -= written;
+        }
+        return true;
+    }
+
+    // Read exactly the given number of bytes from a socket. Returns false if
+    // the connection is closed before that.
+    inline bool readFully(int fd, void* buffer, size_t length) {
+        auto bytes = static_cast<unsigned char*>(buffer);
+        while (length > 0) {
+            ssize_t count = read(fd, bytes, length);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            bytes += count;
+            length -= count;
+        }
+        return true;
+    }
+
+    inline bool writeInt(int fd, int value) {
+        return writeFully(fd,
+                          reinterpret_cast<const unsigned char*>(&value),
+                          sizeof value);
+    }
+
+    // Write an int to a socket, together with a file descriptor that the
+    // receiver gets its own copy of. No descriptor is sent if passedFd is -1.
+    inline bool writeIntWithFd(int fd, int value, int passedFd) {
+        if (passedFd < 0) {
+            return writeInt(fd, value);
+        }
+
+        iovec data;
+        data.iov_base = &value;
+        data.iov_len = sizeof value;
+        char control[CMSG_SPACE(sizeof passedFd)];
+        memset(control, 0, sizeof control);
+
+        msghdr header;
+        memset(&header, 0, sizeof header);
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof control;
+        cmsghdr* controlHeader = CMSG_FIRSTHDR(&header);
+        controlHeader->cmsg_level = SOL_SOCKET;
+        controlHeader->cmsg_type = SCM_RIGHTS;
+        controlHeader->cmsg_len = CMSG_LEN(sizeof passedFd);
+        memcpy(CMSG_DATA(controlHeader), &passedFd, sizeof passedFd);
+
+        ssize_t written;
+        do {
+            written = sendmsg(fd, &header, MSG_NOSIGNAL);
+        } while (written < 0 && errno == EINTR);
+        return written == sizeof value;
+    }
+
+    // Read an int from a socket, and the file descriptor that was sent with
+    // it, if any. passedFd is set to -1 if there was none.
+    inline bool readIntWithFd(int fd, int& value, int& passedFd) {
+        iovec data;
+        data.iov_base = &value;
+        data.iov_len = sizeof value;
+        char control[CMSG_SPACE(sizeof passedFd)];
+
+        msghdr header;
+        memset(&header, 0, sizeof header);
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof control;
+
+        ssize_t count;
+        do {
+            count = recvmsg(fd, &header, MSG_CMSG_CLOEXEC);
+        } while (count < 0 && errno == EINTR);
+
+        passedFd = -1;
+        cmsghdr* controlHeader = CMSG_FIRSTHDR(&header);
+        if (count > 0 &&
+            controlHeader != nullptr &&
+            controlHeader->cmsg_level == SOL_SOCKET &&
+            controlHeader->cmsg_type == SCM_RIGHTS) {
+            memcpy(&passedFd, CMSG_DATA(controlHeader), sizeof passedFd);
+        }
+        if (count <= 0) {
+            return false;
+        }
+
+        // The rest of the int, if the socket handed it out in pieces.
+        return readFully(fd,
+                         reinterpret_cast<unsigned char*>(&value) + count,
+                         sizeof value - count);
+    }
+
+    inline bool makeSocketAddress(
+        const std::string& path,
+        sockaddr_un& address) {
+
+        if (path.empty() || path.size() >= sizeof address.sun_path) {
+            return false;
+        }
+        memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        memcpy(address.sun_path, path.data(), path.size());
+        return true;
+    }
+
+    inline int readFrameInt(const unsigned char* bytes) {
+        int value;
+        memcpy(&value, bytes, sizeof value);
+        return value;
+    }
+
+    // The shared memory of a link holds the ring from the executable that
+    // connected to the one that listens, followed by the ring in the other
+    // direction.
+    const size_t sharedMemorySize = 2 * sizeof(SharedRing);
+
+    // Create the shared memory of a link. Returns the file descriptor of the
+    // memory, or -1 if it could not be created.
+    inline int createSharedMemory() {
+        int fd = memfd_create("buhrlang-node-link", MFD_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        if (ftruncate(fd, sharedMemorySize) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Map the shared memory of a link, and close its file descriptor, which
+    // the mapping does not need. Returns null if it could not be mapped. The
+    // memory is initially zero, which is an empty ring with nobody sleeping.
+    inline void* mapSharedMemory(int fd) {
+        if (fd < 0) {
+            return nullptr;
+        }
+        void* memory = mmap(nullptr,
+                            sharedMemorySize,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED,
+                            fd,
+                            0);
+        close(fd);
+        return memory == MAP_FAILED ? nullptr : memory;
+    }
+
+    inline NodeLink::NodeLink(
+        NodeNetwork& nodeNetwork,
+        int fd,
+        int node,
+        SharedRing* outgoing,
+        SharedRing* incoming,
+        void* memory) :
+        network(nodeNetwork),
+        socketFd(fd),
+        peerNode(node),
+        outgoingRing(outgoing),
+        incomingRing(incoming),
+        sharedMemory(memory),
+        mutex(),
+        ringWriterMutex(),
+        condition(),
+        output(),
+        isClosed(false) {}
+
+    inline NodeLink::~NodeLink() {
+        ::close(socketFd);
+        if (sharedMemory != nullptr) {
+            munmap(sharedMemory, sharedMemorySize);
+        }
+    }
+
+    inline void NodeLink::start(const std::shared_ptr<NodeLink>& self) {
+        // Each thread keeps the link alive until it is done with the socket and
+        // the shared memory.
+        if (sharedMemory != nullptr) {
+            std::thread([self] { self->runRingReader(); }).detach();
+        } else {
+            std::thread([self] { self->runWriter(); }).detach();
+        }
+        std::thread([self] { self->runReader(); }).detach();
+    }
+
+    // Serialize a message and send it to the other executable. A frame on the
+    // link is the number of bytes that follow, the PID of the receiver, and the
+    // serialized message. Returns false if the link is closed.
+    inline bool NodeLink::send(int destinationPid, Message& message) {
+        Pointer<ByteBuffer> buffer(new ByteBuffer());
+        message._serialize(buffer);
+        const std::vector<unsigned char>& bytes = buffer->getBytes();
+        int frameLength = sizeof destinationPid + bytes.size();
+        auto frameLengthBytes = reinterpret_cast<unsigned char*>(&frameLength);
+        auto pidBytes = reinterpret_cast<unsigned char*>(&destinationPid);
+
+        if (sharedMemory != nullptr) {
+            // The ring has one writer, so the senders take turns. Each frame is
+            // written as a whole before the next sender gets its turn.
+            std::lock_guard<std::mutex> lock(ringWriterMutex);
+            return writeToRing(frameLengthBytes, sizeof frameLength) &&
+                   writeToRing(pidBytes, sizeof destinationPid) &&
+                   writeToRing(bytes.data(), bytes.size());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (isClosed) {
+            return false;
+        }
+        bool wasEmpty = output.empty();
+        output.insert(output.end(),
+                      frameLengthBytes,
+                      frameLengthBytes + sizeof frameLength);
+        output.insert(output.end(), pidBytes, pidBytes + sizeof destinationPid);
+        output.insert(output.end(), bytes.begin(), bytes.end());
+        if (wasEmpty) {
+            // The writer only waits when there is no output.
+            condition.notify_one();
+        }
+        return true;
+    }
+
+    inline void NodeLink::close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (isClosed) {
+                return;
+            }
+            isClosed = true;
+            condition.notify_one();
+        }
+
+        if (sharedMemory != nullptr) {
+            // Wake up our ring reader and writer, if they sleep.
+            sharedFutexWake(&incomingRing->readerSleeping);
+            sharedFutexWake(&outgoingRing->writerSleeping);
+        }
+
+        // Wake up the socket reader, and tell the other executable.
+        shutdown(socketFd, SHUT_RDWR);
+        network.removeLink(this);
+    }
+
+    inline void NodeLink::runWriter() {
+        std::vector<unsigned char> batch;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            condition.wait(lock, [this] {
+                return isClosed || !output.empty();
+            });
+            if (isClosed) {
+                return;
+            }
+
+            // Take all output and write it without holding the lock, so that
+            // senders can append the next batch in the meantime.
+            batch.swap(output);
+            lock.unlock();
+            bool isWritten = writeFully(socketFd, batch.data(), batch.size());
+            batch.clear();
+            if (!isWritten) {
+                close();
+                return;
+            }
+            lock.lock();
+        }
+    }
+
+    // Read the socket until the other executable closes it. When the messages
+    // are carried by shared memory nothing is read, but the socket still tells
+    // when the other executable is gone.
+    inline void NodeLink::runReader() {
+        std::vector<unsigned char> input;
+        size_t length = 0;
+
+        while (true) {
+            input.resize(length + nodeLinkReadSize);
+            ssize_t count =
+                read(socketFd, input.data() + length, nodeLinkReadSize);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            length += count;
+            input.resize(length);
+            if (!deliverFrames(input)) {
+                break;
+            }
+            length = input.size();
+        }
+        close();
+    }
+
+    // Read the incoming ring until the link is closed and the ring is empty.
+    // All bytes that are in the ring are taken at once, which makes room for
+    // the writer right away.
+    inline void NodeLink::runRingReader() {
+        std::vector<unsigned char> input;
+        SharedRing* ring = incomingRing;
+
+        while (true) {
+            // The link is looked at before the ring. When the other executable
+            // is gone, whatever it wrote before is in the ring, and is
+            // delivered before the reader stops.
+            bool wasClosed = isClosed;
+            uint64_t readIndex =
+                ring->readIndex.load(std::memory_order_relaxed);
+            uint64_t writeIndex =
+                ring->writeIndex.load(std::memory_order_acquire);
+            if (writeIndex == readIndex) {
+                if (wasClosed) {
+                    break;
+                }
+                waitForRing(ring->writeIndex, readIndex, ring->readerSleeping);
+                continue;
+            }
+
+            size_t length = writeIndex - readIndex;
+            size_t start = readIndex & sharedRingMask;
+            size_t firstPart = std::min(length, sharedRingCapacity - start);
+            input.insert(input.end(),
+                         ring->data + start,
+                         ring->data + start + firstPart);
+            input.insert(input.end(),
+                         ring->data,
+                         ring->data + length - firstPart);
+            ring->readIndex.store(writeIndex, std::memory_order_seq_cst);
+            wakeRingPeer(ring->writerSleeping);
+
+            if (!deliverFrames(input)) {
+                break;
+            }
+        }
+        close();
+    }
+
+    // Write bytes to the outgoing ring, waiting for the reader to make room
+    // when the ring is full. A frame that is bigger than the ring goes through
+    // in pieces. Returns false if the link is closed.
+    inline bool NodeLink::writeToRing(
+        const unsigned char* bytes,
+        size_t length) {
+
+        SharedRing* ring = outgoingRing;
+        uint64_t writeIndex = ring->writeIndex.load(std::memory_order_relaxed);
+
+        while (length > 0) {
+            if (isClosed) {
+                return false;
+            }
+            uint64_t readIndex =
+                ring->readIndex.load(std::memory_order_acquire);
+            size_t space = sharedRingCapacity - (writeIndex - readIndex);
+            if (space == 0) {
+                waitForRing(ring->readIndex, readIndex, ring->writerSleeping);
+                continue;
+            }
+
+            size_t count = std::min(length, space);
+            size_t start = writeIndex & sharedRingMask;
+            size_t firstPart = std::min(count, sharedRingCapacity - start);
+            memcpy(ring->data + start, bytes, firstPart);
+            memcpy(ring->data, bytes + firstPart, count - firstPart);
+            writeIndex += count;
+            bytes += count;
+            length -= count;
+            ring->writeIndex.store(writeIndex, std::memory_order_seq_cst);
+            wakeRingPeer(ring->readerSleeping);
+        }
+        return true;
+    }
+
+    // Wait until the index of the other side of a ring no longer has the given
+    // value. Spins for a while, since the other side usually is quick, and then
+    // sleeps on the futex word until the other side wakes us up. Returns false
+    // if the index still has the value, because we timed out or were woken up
+    // for another reason.
+    inline bool NodeLink::waitForRing(
+        std::atomic<uint64_t>& index,
+        uint64_t value,
+        std::atomic<int>& sleeping) {
+
+        for (int i = 0; i < sharedRingSpinCount; i++) {
+            if (index.load(std::memory_order_acquire) != value) {
+                return true;
+            }
+            spinPause();
+        }
+
+        // Say that we sleep before the last look at the index. The other side
+        // moves the index before it looks whether we sleep, so one of us sees
+        // what the other did.
+        sleeping.store(1, std::memory_order_seq_cst);
+        if (index.load(std::memory_order_seq_cst) == value && !isClosed) {
+            sharedFutexWait(&sleeping, 1, sharedRingWaitMilliseconds);
+        }
+        sleeping.store(0, std::memory_order_relaxed);
+        return index.load(std::memory_order_acquire) != value;
+    }
+
+    inline void NodeLink::wakeRingPeer(std::atomic<int>& sleeping) {
+        if (sleeping.load(std::memory_order_seq_cst) != 0) {
+            sleeping.store(0, std::memory_order_relaxed);
+            sharedFutexWake(&sleeping);
+        }
+    }
+
+    // Deliver the complete frames at the start of the input, and remove them
+    // from the input. Returns false if a frame could not be deserialized, after
+    // which the link is useless.
+    inline bool NodeLink::deliverFrames(std::vector<unsigned char>& input) {
+        size_t position = 0;
+        const size_t headerLength = 2 * sizeof(int);
+
+        while (input.size() - position >= headerLength) {
+            const unsigned char* frame = input.data() + position;
+            int frameLength = readFrameInt(frame);
+            if (frameLength < static_cast<int>(sizeof(int))) {
+                return false;
+            }
+            if (input.size() - position < sizeof(int) + frameLength) {
+                break;
+            }
+            int destinationPid = readFrameInt(frame + sizeof(int));
+
+            Pointer<Message> message;
+            try {
+                Pointer<ByteBuffer> buffer(
+                    new ByteBuffer(frame + headerLength,
+                                   frameLength - sizeof(int)));
+                message = dynamicPointerCast<Message>(buffer->readObject());
+            } catch (const SerializationException& exception) {
+                fprintf(stderr,
+                        "Message from node %d dropped: %s\n",
+                        peerNode,
+                        exception.what());
+                return false;
+            }
+            if (message.get() != nullptr) {
+                // Messages in the kernel are not reference counted.
+                std::unique_ptr<Message> receivedMsg(message.release());
+                network.deliver(destinationPid, std::move(receivedMsg));
+            }
+            position += sizeof(int) + frameLength;
+        }
+
+        input.erase(input.begin(), input.begin() + position);
+        return true;
+    }
+
+    inline NodeNetwork::NodeNetwork(
+        int id,
+        FindProcessFunction findProcessFunction,
+        DeliverFunction deliverFunction) :
+        nodeId(id),
+        findProcess(findProcessFunction),
+        deliverMessage(deliverFunction),
+        mutex(),
+        links() {}
+
+    // Start accepting connections from other executables on a Unix domain
+    // socket at the given path. A stale socket file at the path is removed
+    // first.
+    inline bool NodeNetwork::listen(const std::string& socketPath) {
+        sockaddr_un address;
+        if (nodeId == 0 || !makeSocketAddress(socketPath, address)) {
+            return false;
+        }
+
+        int listenerFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenerFd < 0) {
+            return false;
+        }
+        unlink(socketPath.c_str());
+        if (bind(listenerFd,
+                 reinterpret_cast<sockaddr*>(&address),
+                 sizeof address) != 0 ||
+            ::listen(listenerFd, nodeListenBacklog) != 0) {
+            ::close(listenerFd);
+            return false;
+        }
+
+        std::thread(&NodeNetwork::acceptConnections, this, listenerFd).detach();
+        return true;
+    }
+
+    // Connect to the executable listening at the given path, and return the PID
+    // of its process of the given name, or 0. The connection starts with a
+    // handshake: we send our node ID, together with the shared memory for the
+    // link if we could create it, and the name. The other side answers with its
+    // node ID and the PID. Afterwards the connection becomes the link between
+    // the two nodes, unless they are linked already.
+    inline int NodeNetwork::connect(
+        const std::string& socketPath,
+        const std::string& processName) {
+
+        sockaddr_un address;
+        if (nodeId == 0 || !makeSocketAddress(socketPath, address)) {
+            return 0;
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return 0;
+        }
+        int sharedMemoryFd = createSharedMemory();
+        int peerNode = 0;
+        int pid = 0;
+        bool isConnected =
+            ::connect(fd,
+                      reinterpret_cast<sockaddr*>(&address),
+                      sizeof address) == 0 &&
+            writeIntWithFd(fd, nodeId, sharedMemoryFd) &&
+            writeInt(fd, processName.size()) &&
+            writeFully(
+                fd,
+                reinterpret_cast<const unsigned char*>(processName.data()),
+                processName.size()) &&
+            readFully(fd, &peerNode, sizeof peerNode) &&
+            readFully(fd, &pid, sizeof pid) &&
+            peerNode > 0 &&
+            peerNode != nodeId;
+
+        void* sharedMemory = mapSharedMemory(sharedMemoryFd);
+        if (!isConnected) {
+            if (sharedMemory != nullptr) {
+                munmap(sharedMemory, sharedMemorySize);
+            }
+            ::close(fd);
+            return 0;
+        }
+
+        addLink(fd, peerNode, sharedMemory, true);
+        return pid;
+    }
+
+    inline bool NodeNetwork::send(int destinationPid, Message& message) {
+        std::shared_ptr<NodeLink> link;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto i = links.find(destinationPid >> nodeIdShift);
+            if (i == links.end()) {
+                return false;
+            }
+            link = i->second;
+        }
+        return link->send(destinationPid, message);
+    }
+
+    inline void NodeNetwork::removeLink(const NodeLink* link) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto i = links.find(link->getPeerNode());
+        if (i != links.end() && i->second.get() == link) {
+            links.erase(i);
+        }
+    }
+
+    inline void NodeNetwork::acceptConnections(int listenerFd) {
+        while (true) {
+            int fd = accept4(listenerFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                ::close(listenerFd);
+                return;
+            }
+            acceptConnection(fd);
+        }
+    }
+
+    // Answer the handshake sent by NodeNetwork::connect().
+    inline void NodeNetwork::acceptConnection(int fd) {
+        int peerNode = 0;
+        int sharedMemoryFd = -1;
+        int nameLength = 0;
+        bool isReceived = readIntWithFd(fd, peerNode, sharedMemoryFd) &&
+                          readFully(fd, &nameLength, sizeof nameLength) &&
+                          nameLength >= 0;
+        void* sharedMemory = mapSharedMemory(sharedMemoryFd);
+
+        std::string processName(isReceived ? nameLength : 0, '\0');
+        bool isValidPeer = isReceived &&
+                           readFully(fd, &processName[0], nameLength) &&
+                           peerNode > 0 &&
+                           peerNode != nodeId;
+        int pid = isValidPeer ? findProcess(processName) : 0;
+        if (!isReceived ||
+            !writeInt(fd, isValidPeer ? nodeId : 0) ||
+            !writeInt(fd, pid) ||
+            !isValidPeer) {
+            if (sharedMemory != nullptr) {
+                munmap(sharedMemory, sharedMemorySize);
+            }
+            ::close(fd);
+            return;
+        }
+
+        addLink(fd, peerNode, sharedMemory, false);
+    }
+
+    // Make the connection the link to the given node. If the nodes are linked
+    // already, the existing link is kept, and the connection, which then only
+    // served to look up a process, is closed. The other side does the same, so
+    // both keep the same link.
+    inline void NodeNetwork::addLink(
+        int fd,
+        int peerNode,
+        void* sharedMemory,
+        bool isConnector) {
+
+        SharedRing* outgoing = nullptr;
+        SharedRing* incoming = nullptr;
+        if (sharedMemory != nullptr) {
+            auto rings = static_cast<SharedRing*>(sharedMemory);
+            outgoing = isConnector ? &rings[0] : &rings[1];
+            incoming = isConnector ? &rings[1] : &rings[0];
+        }
+        auto link = std::make_shared<NodeLink>(*this,
+                                               fd,
+                                               peerNode,
+                                               outgoing,
+                                               incoming,
+                                               sharedMemory);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (links.find(peerNode) != links.end()) {
+                return;
+            }
+            links[peerNode] = link;
+        }
+        link->start(link);
+    }
+}
+
+#endif
@@ -1,3 +1,5 @@
+import "ByteBuffer"
+
 message enum Option<T> {
     Some(T),
     None
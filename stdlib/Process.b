@@ -1,4 +1,5 @@
 import "Message"
+import "ProcessMetrics"
 import "System"
 
 native class Process {
@@ -14,24 +15,136 @@ native class Process {
     // Register a message handler for the current process.
     static int registerMessageHandler(MessageHandler messageHandler)
 
-    // Send a message to a process.
-    static send(int destinationPid, Message msg)
+    // Send a message to a process and return the message ID, or 0 if the
+    // message could not be sent. If nothing else references the message or any
+    // object in it, the message is handed over to the destination process as
+    // it is. Otherwise, a copy is sent.
+    static int send(int destinationPid, Message msg)
+
+    // Send a number of messages to the same process, in order, and return the
+    // number of messages that were sent. Each message is handed over or copied
+    // just like with send(), and gets its message ID set. Unless the mailbox
+    // limit of the destination process gets in the way, all messages are added
+    // to the mailbox at once, which is cheaper than sending them one by one.
+    static int sendBatch(int destinationPid, Message[] messages)
+
+    // Add the current process to the given process group. A process that
+    // terminates leaves all groups it has joined.
+    static join(string group)
+
+    // Remove the current process from the given process group.
+    static leave(string group)
+
+    // Send a message to every process in the given group, and return the
+    // number of processes it was sent to. Every process gets its own copy of
+    // the data, the same as when the message is sent to each of them.
+    static int publish(string group, Message msg)
+
+    // Let processes in other Buhrlang executables on the same machine send
+    // messages to the processes of this executable, through a Unix domain
+    // socket at the given path. Returns false if the socket could not be
+    // created, or if the executable has no node ID. The node ID is set by the
+    // BUHRLANG_NODE environment variable, and must be unique among the
+    // executables that talk to each other.
+    static bool listen(string socketPath)
+
+    // Connect to the executable that listens at the given socket path, and
+    // return the PID of its process of the given name, or 0 if there is no
+    // such process or the connection failed. Messages sent to the PID, and
+    // calls made through a proxy created from it, are serialized and forwarded
+    // to the other executable. Processes there can reply to, or call, any
+    // process of this executable in the same way. The current thread is
+    // blocked until the other executable has answered.
+    static int connect(string socketPath, string name)
+
+    // Return the node ID of this executable, or 0 if it has none.
+    static int getNode()
+
+    // Send a message to a process once the given number of milliseconds have
+    // passed, and return the ID of the timer. The message is handed over or
+    // copied right away, just like with send().
+    static int sendAfter(int destinationPid, Message msg, int milliseconds)
+
+    // Cancel a timer started by sendAfter(). Returns false if the timer has
+    // already expired.
+    static bool cancelTimer(int timerId)
 
     // Receive a message.
     static Message receive()
 
+    // Receive a message, but wait at most the given number of milliseconds.
+    // If no message arrives in time, a message of type MessageType.Timeout is
+    // returned.
+    static Message receive(int timeoutMilliseconds)
+
+    // Receive at least one and at most the given number of messages. Blocks
+    // until a message arrives, and then also returns the messages that are
+    // already waiting, without blocking for more.
+    static Message[] receiveAll(int max)
+
     // Receive a method result message that matches the given ID.
     static Message receiveMethodResult(int messageId)
 
     // Receive a message that matches the given type and ID.
     static Message receive(int messageType, int messageId)
 
+    // Return true if a method result that matches the given ID has been
+    // received. Never blocks.
+    static bool hasMethodResult(int messageId)
+
+    // Wait at most the given number of milliseconds for a method result that
+    // matches the given ID. Returns true if the result has been received. The
+    // result is kept and can be received later.
+    static bool waitForMethodResult(int messageId, int timeoutMilliseconds)
+
+    // Limit the number of method calls that can be queued in the mailbox of
+    // each process that the current process spawns from now on. The overflow
+    // policy is one of the MailboxOverflow values and decides what happens to
+    // a call that is sent to a full mailbox. A capacity of 0 means no limit,
+    // which is the default. A process that sends to itself is never limited.
+    static setSpawnMailboxLimit(int capacity, int overflowPolicy)
+
+    // Decide where the processes that the current process spawns from now on
+    // are run. The placement is one of the ProcessPlacement values. The core
+    // is only used by ProcessPlacement.Pinned. In the default scheduling mode
+    // the thread of the process is bound to the chosen cores. In the workers
+    // mode the process is run by a worker pinned to the chosen cores.
+    static setSpawnPlacement(int placement, int core)
+
+    // Decide whether the processes that the current process spawns from now
+    // on allocate the objects they create while handling a method call from a
+    // region. A region hands out memory by bumping a pointer, and when all
+    // objects from the region are gone after a call, the memory is used again
+    // for the next call. Objects that are stored or sent stay valid, but they
+    // keep the memory of the region around them from being reused until they
+    // are gone, so this suits processes whose calls mostly create temporary
+    // objects. A process pins at most 17 chunks of 64 KB this way; after that
+    // it allocates from the heap. Off by default, and only takes effect in
+    // programs built with "bc -r".
+    static setSpawnRegionAllocation(bool enabled)
+
+    // Return the highest number of method calls that have been queued in the
+    // mailbox of the given process at the same time, or -1 if there is no such
+    // process.
+    static int getMailboxHighWaterMark(int pid)
+
+    // Return the number of method calls that are queued for the given process
+    // and not yet handled, or -1 if there is no such process.
+    static int getMailboxLength(int pid)
+
+    // Return a snapshot of the metrics of all live processes.
+    static ProcessMetrics[] getMetrics()
+
     // Return the PID of the current process.
     static int getPid()
 
     // Terminate the current process.
     static terminate()
 
+    // Terminate the given process once it has handled the messages that are
+    // already in its mailbox.
+    static terminate(int pid)
+
     // Wait for a given process to terminate.
     static wait(int pid)
 
@@ -2,18 +2,36 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <list>
+#include <ucontext.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <deque>
+#include <algorithm>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <memory>
 
 #include "Utils.h"
 #include "Exception.h"
+#include "Futex.h"
+#include "NodeNetwork.h"
+#include "TimerWheel.h"
+#include "Tracer.h"
+
+using namespace ProcessRuntime;
 
 void _main_();
 
@@ -24,17 +42,348 @@ namespace {
         return std::unique_ptr<T>(new T(std::forward<Ts>(params)...));
     }
 
+    using Clock = std::chrono::steady_clock;
+
+    // Size of the stack of a process that runs as a coroutine on a worker
+    // thread. The stack memory is committed lazily by the OS, so a process only
+    // pays for the pages it actually touches.
+    const size_t coroutineStackSize = 256 * 1024;
+
+    // Maximum number of stacks of terminated processes that a worker keeps for
+    // reuse.
+    const size_t maxPooledStacks = 256;
+
+    // Number of times a receiving thread polls an empty mailbox before it goes
+    // to sleep. Spinning is pointless when there is only one CPU, since the
+    // sender cannot run while we spin.
+    const int mailboxSpinCount =
+        std::thread::hardware_concurrency() > 1 ? 100 : 0;
+
+    // Number of times a sender that is blocked on a full mailbox yields before
+    // it starts to sleep between attempts.
+    const int mailboxYieldCount = 64;
+
+    // Maximum number of messages a process takes out of its mailbox at a time
+    // before it handles them.
+    const size_t receiveBatchSize = 64;
+
+    // Number of times in a row a worker may switch directly from one process
+    // to another before it goes back to its run queue, so that a pair of
+    // processes that keep calling each other cannot starve the others.
+    const int maxConsecutiveHandoffs = 64;
+
+    // Number of elements in the queueing delay histogram of a process.
+    // Element i counts the messages that waited less than 2^i microseconds.
+    const int queueingDelayBucketCount = 24;
+
+    // Memory policy of mbind() that prefers the given node but falls back to
+    // other nodes when it is out of memory.
+    const int memoryPolicyPreferred = 1;
+
+    // Signal that makes the runtime print the metrics of all processes.
+    const int metricsDumpSignal = SIGUSR1;
+
+    // Lock-free multiple producer single consumer queue of messages. The
+    // messages are linked through their _next field, so adding a message does
+    // not allocate any memory. Any thread may add messages, but only the
+    // owning process may remove them.
+    class Mailbox {
+    public:
+        Mailbox();
+        ~Mailbox();
+
+        void push(Message* message);
+        void push(Message* first, Message* last);
+        Message* pop();
+
+        static void link(Message* message, Message* next) {
+            setNext(message, next);
+        }
+
+        // Only meaningful when called by the owning process. A message that is
+        // about to be added makes the mailbox non-empty even though it cannot
+        // be popped yet.
+        bool isEmpty() const {
+            return head.load() == tail;
+        }
+
+    private:
+        static Message* getNext(Message* message) {
+            return reinterpret_cast<Message*>(
+                __atomic_load_n(&message->_next, __ATOMIC_ACQUIRE));
+        }
+
+        static void setNext(Message* message, Message* next) {
+            __atomic_store_n(&message->_next,
+                             reinterpret_cast<long long>(next),
+                             __ATOMIC_RELEASE);
+        }
+
+        // Producers add messages at the head.
+        std::atomic<Message*> head;
+
+        // The consumer removes messages at the tail.
+        Message* tail;
+
+        // Dummy message that keeps the queue non-empty internally.
+        Message stub;
+    };
+
+    // Messages that have been removed from the mailbox by a selective receive
+    // without matching it. Only accessed by the owning process.
+    class DeferredMessageQueue {
+    public:
+        DeferredMessageQueue() : first(nullptr), last(nullptr) {}
+        ~DeferredMessageQueue();
+
+        bool isEmpty() const {
+            return first == nullptr;
+        }
+
+        Message* front() const {
+            return first;
+        }
+
+        void pushBack(Message* message);
+        void pushFront(Message* message);
+        Message* popFront();
+        Message* remove(int messageType, int messageId);
+
+    private:
+        static Message* getNext(Message* message) {
+            return reinterpret_cast<Message*>(message->_next);
+        }
+
+        static void setNext(Message* message, Message* next) {
+            message->_next = reinterpret_cast<long long>(next);
+        }
+
+        Message* first;
+        Message* last;
+    };
+
+    // Method results and child termination notifications that have been
+    // removed from the mailbox before anyone asked for them, indexed by message
+    // type and ID so that a waiting receiver finds its reply in constant time.
+    // The replies are also kept in the order they arrived in the mailbox, by
+    // the time they were added to it, so that the ones nobody waits for are
+    // handed out oldest first. Only accessed by the owning process.
+    class PendingReplyTable {
+    public:
+        PendingReplyTable() : arrivals(), replies() {}
+        ~PendingReplyTable();
+
+        bool isEmpty() const {
+            return arrivals.empty();
+        }
+
+        // The time the oldest reply was added to the mailbox. The table must
+        // not be empty.
+        long long getOldestArrival() const {
+            return arrivals.begin()->first;
+        }
+
+        void insert(Message* message);
+        Message* remove(int messageType, int messageId);
+        Message* removeOldest();
+
+        bool contains(int messageType, int messageId) const {
+            return replies.count(makeKey(messageType, messageId)) != 0;
+        }
+
+        static bool isReply(int messageType) {
+            return messageType == MessageType::MethodResult ||
+                   messageType == MessageType::ChildTerminated;
+        }
+
+    private:
+        static long long makeKey(int messageType, int messageId) {
+            return (static_cast<long long>(messageType) << 32) |
+                   static_cast<unsigned int>(messageId);
+        }
+
+        // Replies that were added to the mailbox at the same time keep the
+        // order they were inserted in.
+        using ArrivalMap = std::multimap<long long, Message*>;
+        using ReplyMap =
+            std::unordered_multimap<long long, ArrivalMap::iterator>;
+
+        ArrivalMap arrivals;
+        ReplyMap replies;
+    };
+
+    // The number of method calls a mailbox can hold, and what happens to a
+    // call that is sent to a full mailbox. A capacity of zero means no limit.
+    struct MailboxLimit {
+        MailboxLimit() : capacity(0), overflowPolicy(MailboxOverflow::Block) {}
+        MailboxLimit(int c, int policy) : capacity(c), overflowPolicy(policy) {}
+
+        int capacity;
+        int overflowPolicy;
+    };
+
+    // Counters that describe what a process has been doing. Only the process
+    // itself updates them, so an update is a plain load and store, but other
+    // threads may read them at any time.
+    struct ProcessCounters {
+        ProcessCounters() :
+            messagesReceived(0),
+            messagesSent(0),
+            handlingNanoseconds(0),
+            queueingDelays() {
+
+            for (auto& count: queueingDelays) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        static void add(std::atomic<long long>& counter, long long value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value,
+                          std::memory_order_relaxed);
+        }
+
+        static long long read(const std::atomic<long long>& counter) {
+            return counter.load(std::memory_order_relaxed);
+        }
+
+        std::atomic<long long> messagesReceived;
+        std::atomic<long long> messagesSent;
+        std::atomic<long long> handlingNanoseconds;
+        std::atomic<long long> queueingDelays[queueingDelayBucketCount];
+    };
+
+    // A copy of the metrics of a process, taken by the kernel.
+    struct ProcessMetricsSnapshot {
+        int pid;
+        std::string name;
+        long long messagesReceived;
+        long long messagesSent;
+        int mailboxLength;
+        int mailboxHighWaterMark;
+        long long handlingNanoseconds;
+        long long queueingDelays[queueingDelayBucketCount];
+    };
+
+    // Return the upper bound, in microseconds, of the queueing delay of the
+    // given percent of the messages received by a process.
+    long long getQueueingDelayPercentile(
+        const ProcessMetricsSnapshot& metrics,
+        int percent) {
+
+        long long total = 0;
+        for (auto count: metrics.queueingDelays) {
+            total += count;
+        }
+        if (total == 0) {
+            return 0;
+        }
+
+        long long limit = (total * percent + 99) / 100;
+        long long seen = 0;
+        for (int i = 0; i < queueingDelayBucketCount; i++) {
+            seen += metrics.queueingDelays[i];
+            if (seen >= limit) {
+                return 1LL << i;
+            }
+        }
+        return 1LL << queueingDelayBucketCount;
+    }
+
+    long long toNanoseconds(Clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            time.time_since_epoch()).count();
+    }
+
+    // Where to run a spawned process. See ProcessPlacement.
+    struct Placement {
+        Placement() : policy(ProcessPlacement::Default), core(0) {}
+        Placement(int p, int c) : policy(p), core(c) {}
+
+        int policy;
+        int core;
+    };
+
+    // The CPUs the program may run on, grouped by NUMA node. Without NUMA
+    // information in sysfs, all CPUs are in one node.
+    class CpuTopology {
+    public:
+        CpuTopology();
+
+        int getNodeCount() const {
+            return nodes.size();
+        }
+
+        const std::vector<int>& getNodeCpus(int node) const {
+            return nodes[node].cpus;
+        }
+
+        int getNodeId(int node) const {
+            return nodes[node].id;
+        }
+
+        const std::vector<int>& getCpus() const {
+            return cpus;
+        }
+
+        int getNodeOfCpu(int cpu) const;
+
+    private:
+        struct Node {
+            int id;
+            std::vector<int> cpus;
+        };
+
+        static std::vector<int> parseCpuList(const char* list);
+
+        std::vector<Node> nodes;
+        std::vector<int> cpus;
+    };
+
+    void setThreadAffinity(std::thread& thread, const std::vector<int>& cpus) {
+        if (cpus.empty()) {
+            return;
+        }
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (int cpu: cpus) {
+            CPU_SET(cpu, &cpuSet);
+        }
+        // A CPU the program may not run on is ignored, and so is failure.
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet);
+    }
+
+    class Worker;
+
     class ProcessControlBlock {
     public:
         ProcessControlBlock(int id, int parent, const std::string& n);
 
-        void start(MessageHandlerFactory* factory);
+        void start(
+            MessageHandlerFactory* factory,
+            Worker* w,
+            const std::vector<int>& cpus);
         void run(MessageHandlerFactory* factory);
         void terminate();
         int registerMessageHandler(Pointer<MessageHandler> messageHandler);
         void addMessage(std::unique_ptr<Message> message);
+        bool tryAddMessage(
+            std::unique_ptr<Message>& message,
+            bool ignoreLimit);
+        bool tryAddMessages(
+            std::vector<std::unique_ptr<Message>>& messages,
+            bool ignoreLimit);
         std::unique_ptr<Message> getMessage();
+        std::unique_ptr<Message> getMessage(int timeoutMilliseconds);
         std::unique_ptr<Message> getMessage(int messageType, int messageId);
+        void takeMessages(
+            std::vector<Message*>& batch,
+            size_t max,
+            bool block);
+        bool hasReply(int messageType, int messageId);
+        bool waitForReply(
+            int messageType,
+            int messageId,
+            int timeoutMilliseconds);
 
         int getPid() const {
             return pid;
@@ -44,22 +393,308 @@ namespace {
             return name;
         }
 
+        // The process groups the process has joined. Only touched by the
+        // process itself, and by the kernel once the process is gone.
+        std::vector<std::string>& getGroups() {
+            return groups;
+        }
+
+        Worker* getWorker() const {
+            return worker;
+        }
+
+        MessageHandlerFactory* getFactory() const {
+            return factory;
+        }
+
+        ucontext_t* getContext() {
+            return &context;
+        }
+
+        void* getStack() const {
+            return stack;
+        }
+
+        void setStack(void* s) {
+            stack = s;
+        }
+
+        ProcessLocalStorage* getStatics() {
+            return &statics;
+        }
+
+        const MailboxLimit& getMailboxLimit() const {
+            return mailboxLimit;
+        }
+
+        void setMailboxLimit(const MailboxLimit& limit) {
+            mailboxLimit = limit;
+        }
+
+        const MailboxLimit& getSpawnMailboxLimit() const {
+            return spawnMailboxLimit;
+        }
+
+        void setSpawnMailboxLimit(const MailboxLimit& limit) {
+            spawnMailboxLimit = limit;
+        }
+
+        const Placement& getSpawnPlacement() const {
+            return spawnPlacement;
+        }
+
+        void setSpawnPlacement(const Placement& placement) {
+            spawnPlacement = placement;
+        }
+
+        // Only takes effect in programs that are built with region support.
+        void setRegionAllocation(bool enabled) {
+#ifdef BUHRLANG_REGION_ALLOCATOR
+            regionAllocation = enabled;
+#else
+            (void) enabled;
+#endif
+        }
+
+        bool getSpawnRegionAllocation() const {
+            return spawnRegionAllocation;
+        }
+
+        void setSpawnRegionAllocation(bool enabled) {
+            spawnRegionAllocation = enabled;
+        }
+
+        // The region that the objects created by the process are allocated
+        // from right now, or null.
+        Region* getActiveRegion() const {
+            return activeRegion;
+        }
+
+        int getMailboxHighWaterMark() const {
+            return mailboxHighWaterMark.load(std::memory_order_relaxed);
+        }
+
+        int getMailboxLength() const {
+            return queuedCalls.load(std::memory_order_relaxed);
+        }
+
+        void countSent(int count) {
+            ProcessCounters::add(counters.messagesSent, count);
+        }
+
+        void getMetrics(ProcessMetricsSnapshot& metrics) const;
+
     private:
-        using MessageQueue = std::list<std::unique_ptr<Message>>;
+        bool handleMessage(std::unique_ptr<Message> message);
+        void returnTakenMessages();
+        Message* nextMessage(bool block);
+        Message* receiveMessage();
+        Message* takeFromMailbox();
+        void waitForMessage();
+        void notify();
+        void sortOut(Message* message);
+        void countReceived(const Message* message, long long now);
+        void updateHighWaterMark(int queued);
+        void startTimeout(int milliseconds);
+        void stopTimeout();
+
+        bool isStaleTimeout(const Message* message) const {
+            return message->type == MessageType::Timeout &&
+                   message->id != activeTimeoutId;
+        }
+
+        // Values of the wakeup state.
+        enum {
+            Running = 0,
+            Parked = 1
+        };
+
         using MessageHandlerVector = std::vector<Pointer<MessageHandler>>;
 
         int pid;
         int parentPid;
         std::string name;
+        std::vector<std::string> groups;
         Pointer<MessageHandler> defaultMessageHandler;
         MessageHandlerVector messageHandlerVector;
         int messageHandlerIdCounter;
+        Mailbox mailbox;
+        DeferredMessageQueue deferredMessages;
+        PendingReplyTable pendingReplies;
+
+        // Messages the run loop has taken but not yet handled, and the index
+        // of the next one to handle.
+        std::vector<Message*> takenMessages;
+        size_t nextTakenMessage;
+
+        std::atomic<int> wakeupState;
+        ProcessLocalStorage statics;
+
+        // Whether the objects that the process creates while it handles a
+        // message are allocated from its region, and the region while it is
+        // in use.
+        Region region;
+        Region* activeRegion;
+        bool regionAllocation;
+        bool spawnRegionAllocation;
+
+        // Method calls that have been added but not yet handed out, and the
+        // most there has ever been at once. Other message types are not
+        // limited, since dropping or holding back a reply or a termination
+        // notification could leave a process waiting forever.
+        MailboxLimit mailboxLimit;
+        MailboxLimit spawnMailboxLimit;
+        Placement spawnPlacement;
+        std::atomic<int> queuedCalls;
+        std::atomic<int> mailboxHighWaterMark;
+
+        // The timeout the process is waiting for, if any. Timeout messages
+        // with another ID are left over from earlier waits and are dropped.
+        int activeTimeoutId;
+        int timeoutTimerId;
+
+        ProcessCounters counters;
+
+        // Set when the process runs as a coroutine on a worker thread.
+        Worker* worker;
+        MessageHandlerFactory* factory;
+        ucontext_t context;
+        void* stack;
+    };
+
+    // A worker is an OS thread that multiplexes processes running as
+    // coroutines. A process is bound to one worker for its whole lifetime, so
+    // thread local data seen by the process never changes under its feet.
+    class Worker {
+    public:
+        Worker(int c, int n, int id);
+
+        void start();
+        void schedule(ProcessControlBlock* process);
+        bool handOff(ProcessControlBlock* process);
+        void suspend(ProcessControlBlock* process);
+        void sleep(ProcessControlBlock* process, int milliseconds);
+
+        void retireStack(void* stack) {
+            retiredStack = stack;
+        }
+
+        int getCpu() const {
+            return cpu;
+        }
+
+        int getNode() const {
+            return node;
+        }
+
+    private:
+        using RunQueue = std::deque<ProcessControlBlock*>;
+        using SleepQueue = std::multimap<Clock::time_point,
+                                         ProcessControlBlock*>;
+
+        void run();
+        ProcessControlBlock* getNextProcess();
+        void resume(ProcessControlBlock* process);
+        void* allocateStack();
+        void releaseStack(void* stack);
+
         std::thread thread;
-        MessageQueue mailbox;
         std::mutex mutex;
         std::condition_variable condition;
+        RunQueue runQueue;
+        SleepQueue sleepQueue;
+        std::vector<void*> stackPool;
+        void* retiredStack;
+        ucontext_t schedulerContext;
+
+        // A process of this worker that has been woken up by the running
+        // process, and that is switched to directly once the running process
+        // suspends itself. Only accessed from the worker thread.
+        ProcessControlBlock* handoffProcess;
+        int handoffCount;
+
+        // The CPU the worker thread is pinned to, the index of its NUMA node
+        // in the CPU topology, and the OS ID of the node.
+        int cpu;
+        int node;
+        int nodeId;
+    };
+
+    // Reader-writer lock for short critical sections. Readers only do one
+    // atomic increment and decrement, so any number of readers can hold the
+    // lock at the same time without waiting for each other. A writer blocks
+    // new readers and then waits for the current readers to leave.
+    class ReadWriteSpinLock {
+    public:
+        ReadWriteSpinLock() : state(0) {}
+
+        void lockShared();
+        void unlockShared() {
+            state.fetch_sub(1, std::memory_order_release);
+        }
+
+        void lock();
+        void unlock() {
+            state.fetch_and(~writerBit, std::memory_order_release);
+        }
+
+    private:
+        static const unsigned int writerBit = 0x80000000;
+
+        std::atomic<unsigned int> state;
+    };
+
+    class SharedLockGuard {
+    public:
+        explicit SharedLockGuard(ReadWriteSpinLock& l) : lock(l) {
+            lock.lockShared();
+        }
+
+        ~SharedLockGuard() {
+            lock.unlockShared();
+        }
+
+    private:
+        ReadWriteSpinLock& lock;
+    };
+
+    // Makes the objects that the current thread creates while the guard is
+    // alive come from the given region, and resets the region once the
+    // outermost guard of the region is gone. Does nothing if the region is
+    // null.
+    class RegionGuard {
+    public:
+        RegionGuard(Region* r, Region*& active) :
+            region(r),
+            activeRegion(active),
+            previousRegion(active) {
+
+            if (region != nullptr) {
+                activeRegion = region;
+                Region::current() = region;
+            }
+        }
+
+        ~RegionGuard() {
+            if (region != nullptr) {
+                activeRegion = previousRegion;
+                Region::current() = previousRegion;
+                if (previousRegion == nullptr) {
+                    region->reset();
+                }
+            }
+        }
+
+    private:
+        Region* region;
+        Region*& activeRegion;
+        Region* previousRegion;
     };
 
+    // The process table is split into shards so that spawning and removing
+    // processes only locks out senders to a fraction of the processes.
+    const int processTableShardCount = 64;
+
     class Kernel {
     public:
         Kernel();
@@ -68,31 +703,117 @@ namespace {
             MessageHandlerFactory* factory,
             const std::string& name);
         int sendMessage(int destinationPid, std::unique_ptr<Message> message);
+        int sendMessages(
+            int destinationPid,
+            std::vector<std::unique_ptr<Message>>& messages,
+            std::vector<int>& messageIds);
+        int allocateMessageId();
+        void joinGroup(const std::string& group);
+        void leaveGroup(const std::string& group);
+        int publish(const std::string& group, const Message& message);
+        int getMailboxHighWaterMark(int pid);
+        int getMailboxLength(int pid);
+        void getMetrics(std::vector<ProcessMetricsSnapshot>& metrics);
         void waitForProcessTermination(int pid);
         void removeProcess(int pid);
+        int findProcess(const std::string& name);
+        bool deliverRemoteMessage(
+            int destinationPid,
+            std::unique_ptr<Message> message);
+
+        int getNodeId() const {
+            return nodeId;
+        }
+
+        // Return true if the PID belongs to a process in another executable.
+        bool isRemotePid(int pid) const {
+            return nodeId != 0 && (pid >> nodeIdShift) != nodeId;
+        }
 
     private:
+        int allocatePid();
         bool isProcessAlive(int pid);
+        bool deliverMessage(
+            int destinationPid,
+            std::unique_ptr<Message>& message);
+        bool deliverLocalMessage(
+            int destinationPid,
+            std::unique_ptr<Message>& message,
+            bool ignoreLimit);
+        void traceSend(int destinationPid, const Message* message);
+        void removeGroupMember(const std::string& group, int pid);
+        void waitForMailboxSpace(int attempt);
+        void insertProcess(std::unique_ptr<ProcessControlBlock> process);
+        void startWorkers();
+        void startMetricsDumper();
+        void dumpMetricsOnSignal();
+        Worker* selectWorker(const Placement& placement);
+        Worker* selectNodeWorker(int node);
+        std::vector<int> selectCpus(const Placement& placement);
+        int getCurrentNode();
 
         using PidToProcessMap =
-            std::map<int, std::unique_ptr<ProcessControlBlock>>;
+            std::unordered_map<int, std::unique_ptr<ProcessControlBlock>>;
         using NameToProcessMap = std::map<std::string, ProcessControlBlock*>;
+        using GroupMap = std::map<std::string, std::vector<int>>;
+
+        struct ProcessTableShard {
+            ProcessTableShard() : lock(), processMap() {}
+
+            ReadWriteSpinLock lock;
+            PidToProcessMap processMap;
+        };
+
+        ProcessTableShard& getShard(int pid) {
+            return processTable[pid % processTableShardCount];
+        }
 
-        PidToProcessMap processMap;
+        ProcessTableShard processTable[processTableShardCount];
         NameToProcessMap nameToProcessMap;
-        int pidCounter;
-        int messageIdCounter;
-        std::mutex mutex;
+        std::mutex nameMutex;
+        GroupMap groups;
+        std::mutex groupMutex;
+        std::atomic<int> pidCounter;
+        std::atomic<int> messageIdCounter;
+        int nodeId;
+        CpuTopology topology;
+        std::vector<Worker*> workers;
+        std::vector<std::vector<Worker*>> nodeWorkers;
+        std::atomic<unsigned int> nextWorker;
+        std::atomic<unsigned int> nextNode;
     };
 
+    // The tracer is constructed before the kernel, since the kernel may
+    // record events as soon as it is constructed.
+    Tracer tracer;
+
     thread_local ProcessControlBlock* currentProcess;
     Kernel kernel;
 
+    // The timer wheel is never deleted, since its thread outlives main().
+    TimerWheel& timerWheel = *new TimerWheel(
+        [](int destinationPid, std::unique_ptr<Message> message) {
+            kernel.sendMessage(destinationPid, std::move(message));
+        });
+
+    // The node network is never deleted, since the threads of its links
+    // outlive main().
+    NodeNetwork& nodeNetwork = *new NodeNetwork(
+        kernel.getNodeId(),
+        [](const std::string& name) {
+            return kernel.findProcess(name);
+        },
+        [](int destinationPid, std::unique_ptr<Message> message) {
+            return kernel.deliverRemoteMessage(destinationPid,
+                                               std::move(message));
+        });
+
     void processEntryPoint(
         ProcessControlBlock* process,
         MessageHandlerFactory* factory) {
 
         currentProcess = process;
+        ProcessLocalStorage::current() = process->getStatics();
 
         try {
             if (factory != nullptr) {
@@ -110,6 +831,19 @@ namespace {
 
         process->terminate();
     }
+
+    void coroutineEntryPoint() {
+        ProcessControlBlock* process = currentProcess;
+        Worker* worker = process->getWorker();
+        void* stack = process->getStack();
+
+        processEntryPoint(process, process->getFactory());
+
+        // The process control block is gone now. The stack we are running on
+        // is released by the worker once we have switched back to the
+        // scheduler context.
+        worker->retireStack(stack);
+    }
 }
 
 int main() {
@@ -117,6 +851,7 @@ int main() {
     srand(time(&t));
 
     processEntryPoint(currentProcess, nullptr);
+    tracer.flush();
     return 0;
 }
 
@@ -127,50 +862,154 @@ ProcessControlBlock::ProcessControlBlock(
     pid(id),
     parentPid(parent),
     name(n),
+    groups(),
     defaultMessageHandler(nullptr),
     messageHandlerVector(),
     messageHandlerIdCounter(0),
-    thread(),
     mailbox(),
-    mutex(),
-    condition() {}
-
-void ProcessControlBlock::start(MessageHandlerFactory* factory) {
-    thread = std::thread(processEntryPoint, this, factory);
-    thread.detach();
+    deferredMessages(),
+    pendingReplies(),
+    takenMessages(),
+    nextTakenMessage(0),
+    wakeupState(Running),
+    statics(),
+    region(),
+    activeRegion(nullptr),
+    regionAllocation(false),
+    spawnRegionAllocation(false),
+    mailboxLimit(),
+    spawnMailboxLimit(),
+    spawnPlacement(),
+    queuedCalls(0),
+    mailboxHighWaterMark(0),
+    activeTimeoutId(0),
+    timeoutTimerId(0),
+    counters(),
+    worker(nullptr),
+    factory(nullptr),
+    context(),
+    stack(nullptr) {}
+
+void ProcessControlBlock::start(
+    MessageHandlerFactory* f,
+    Worker* w,
+    const std::vector<int>& cpus) {
+
+    if (w == nullptr) {
+        // The thread object is local, since the process may terminate and
+        // delete this process control block before we are done with it.
+        std::thread thread(processEntryPoint, this, f);
+        setThreadAffinity(thread, cpus);
+        thread.detach();
+    } else {
+        worker = w;
+        factory = f;
+        worker->schedule(this);
+    }
 }
 
 void ProcessControlBlock::run(MessageHandlerFactory* factory) {
     Pointer<MessageHandlerFactory> factoryPtr(factory);
     defaultMessageHandler = factoryPtr->createMessageHandler();
 
+    std::vector<Message*> batch;
     while (true) {
-        auto message = std::move(currentProcess->getMessage());
-        int messageType = message->type;
-        if (messageType == MessageType::MethodCall) {
-            Pointer<Message> messagePtr(message.release());
-            int messageHandlerId = messagePtr->messageHandlerId;
-            if (messageHandlerId == 0) {
-                // Route the message to the default message handler (process
-                // object).
-                defaultMessageHandler->handleMessage(messagePtr);
-            } else {
-                // Route the message to the indicated message handler.
-                int index = messageHandlerId - 1;
-                if (index < messageHandlerVector.size()) {
-                    messageHandlerVector[index]->handleMessage(messagePtr);
+        if (nextTakenMessage == takenMessages.size()) {
+            batch.clear();
+            takeMessages(batch, receiveBatchSize, true);
+            takenMessages.swap(batch);
+            nextTakenMessage = 0;
+
+            // The calls that have been taken count as queued until they are
+            // handled, so that the mailbox length and the mailbox limit see
+            // them.
+            int calls = 0;
+            for (auto taken: takenMessages) {
+                if (taken->type == MessageType::MethodCall) {
+                    calls++;
                 }
             }
-        } else if (messageType == MessageType::Terminate) {
+            if (calls > 0) {
+                queuedCalls.fetch_add(calls, std::memory_order_relaxed);
+            }
+        }
+        std::unique_ptr<Message> message(takenMessages[nextTakenMessage++]);
+        if (message->type == MessageType::MethodCall) {
+            queuedCalls.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (handleMessage(std::move(message))) {
             break;
         }
     }
+
+    while (nextTakenMessage < takenMessages.size()) {
+        delete takenMessages[nextTakenMessage++];
+    }
+    takenMessages.clear();
+}
+
+// Dispatch a message to its message handler. Returns true if the message
+// tells the process to terminate.
+bool ProcessControlBlock::handleMessage(std::unique_ptr<Message> message) {
+    int messageType = message->type;
+    if (messageType == MessageType::MethodCall) {
+        // The guard comes before the message, so that the region is reset
+        // after the message is gone.
+        RegionGuard regionGuard(regionAllocation ? &region : nullptr,
+                                activeRegion);
+        Clock::time_point startTime = Clock::now();
+        Pointer<Message> messagePtr(message.release());
+        int messageHandlerId = messagePtr->messageHandlerId;
+        int messageId = messagePtr->id;
+        int interfaceId = messagePtr->interfaceId;
+        if (tracer.isEnabled()) {
+            tracer.record(TraceHandleBegin,
+                          pid,
+                          0,
+                          messageType,
+                          messageId,
+                          interfaceId);
+        }
+        if (messageHandlerId == 0) {
+            // Route the message to the default message handler (process
+            // object).
+            defaultMessageHandler->handleMessage(messagePtr);
+        } else {
+            // Route the message to the indicated message handler.
+            int index = messageHandlerId - 1;
+            if (index < messageHandlerVector.size()) {
+                messageHandlerVector[index]->handleMessage(messagePtr);
+            }
+        }
+        ProcessCounters::add(
+            counters.handlingNanoseconds,
+            toNanoseconds(Clock::now()) - toNanoseconds(startTime));
+        if (tracer.isEnabled()) {
+            tracer.record(TraceHandleEnd,
+                          pid,
+                          0,
+                          messageType,
+                          messageId,
+                          interfaceId);
+        }
+    } else if (messageType == MessageType::Terminate) {
+        return true;
+    }
+    return false;
 }
 
 void ProcessControlBlock::terminate() {
+    // Release the static data of the process while it still is the current
+    // process.
+    statics.clear();
+
+    if (tracer.isEnabled()) {
+        tracer.record(TraceTerminate, pid, parentPid, 0, 0, 0);
+    }
+
     std::unique_ptr<Message> parentNotification;
     int parent = 0;
-    if (pid != 0) {
+    if (pid != parentPid) {
         parentNotification = make_unique<Message>(MessageType::ChildTerminated);
         parentNotification->id = pid;
         parent = parentPid;
@@ -179,6 +1018,7 @@ void ProcessControlBlock::terminate() {
     // This will delete this ProcessControlBlock object, so we cannot access any
     // members after this.
     kernel.removeProcess(pid);
+    currentProcess = nullptr;
 
     if (parentNotification) {
         kernel.sendMessage(parent, std::move(parentNotification));
@@ -196,62 +1036,1060 @@ int ProcessControlBlock::registerMessageHandler(
 }
 
 void ProcessControlBlock::addMessage(std::unique_ptr<Message> message) {
-    std::unique_lock<std::mutex> lock(mutex);
-    mailbox.push_back(std::move(message));
-    condition.notify_one();
+    if (message->type == MessageType::MethodCall) {
+        updateHighWaterMark(
+            queuedCalls.fetch_add(1, std::memory_order_relaxed) + 1);
+    }
+    message->_enqueueTime = toNanoseconds(Clock::now());
+    mailbox.push(message.release());
+    notify();
 }
 
-std::unique_ptr<Message> ProcessControlBlock::getMessage() {
-    std::unique_lock<std::mutex> lock(mutex);
+// Add a batch of messages with one update of the queued call count, one
+// atomic exchange on the mailbox and one wakeup. Returns false, and adds
+// nothing, if the mailbox is limited in a way that requires the messages to
+// be added one by one.
+bool ProcessControlBlock::tryAddMessages(
+    std::vector<std::unique_ptr<Message>>& messages,
+    bool ignoreLimit) {
+
+    if (mailboxLimit.capacity > 0 &&
+        mailboxLimit.overflowPolicy != MailboxOverflow::DropOldest &&
+        !ignoreLimit) {
+        return false;
+    }
+    if (messages.empty()) {
+        return true;
+    }
 
-    // Loop to handle spurious wakeups.
-    while (mailbox.empty()) {
-        condition.wait(lock);
+    long long now = toNanoseconds(Clock::now());
+    int calls = 0;
+    for (size_t i = 0; i < messages.size(); i++) {
+        Message* message = messages[i].get();
+        if (message->type == MessageType::MethodCall) {
+            calls++;
+        }
+        message->_enqueueTime = now;
+        if (i > 0) {
+            Mailbox::link(messages[i - 1].get(), message);
+        }
+    }
+    if (calls > 0) {
+        updateHighWaterMark(
+            queuedCalls.fetch_add(calls, std::memory_order_relaxed) + calls);
     }
-    auto message = std::move(mailbox.front());
-    mailbox.pop_front();    
-    return message;
-}
 
-std::unique_ptr<Message> ProcessControlBlock::getMessage(
-    int messageType,
-    int messageId) {
+    Message* first = messages.front().get();
+    Message* last = messages.back().get();
+    for (auto& message: messages) {
+        message.release();
+    }
+    mailbox.push(first, last);
+    notify();
+    return true;
+}
 
-    std::unique_ptr<Message> matchingMessage;
-    std::unique_lock<std::mutex> lock(mutex);
+void ProcessControlBlock::updateHighWaterMark(int queued) {
+    int highWaterMark = mailboxHighWaterMark.load(std::memory_order_relaxed);
+    while (queued > highWaterMark &&
+           !mailboxHighWaterMark.compare_exchange_weak(
+               highWaterMark,
+               queued,
+               std::memory_order_relaxed)) {}
+}
 
-    while (true) {
-        // Loop to handle spurious wakeups.
-        while (mailbox.empty()) {
-            condition.wait(lock);
+// Add a message unless the mailbox is full. Returns false if the message was
+// not added because the overflow policy is to block the sender or to fail the
+// send. If the policy is to drop the newest call, the message is deleted and
+// true is returned, so the sender does not notice.
+bool ProcessControlBlock::tryAddMessage(
+    std::unique_ptr<Message>& message,
+    bool ignoreLimit) {
+
+    int capacity = mailboxLimit.capacity;
+    if (capacity > 0 &&
+        message->type == MessageType::MethodCall &&
+        mailboxLimit.overflowPolicy != MailboxOverflow::DropOldest &&
+        !ignoreLimit &&
+        queuedCalls.load(std::memory_order_relaxed) >= capacity) {
+
+        if (mailboxLimit.overflowPolicy == MailboxOverflow::DropNewest) {
+            message.reset();
+            return true;
         }
+        return false;
+    }
+    addMessage(std::move(message));
+    return true;
+}
 
-        for (auto i = mailbox.begin(); i != mailbox.end(); i++) {
-            auto message = i->get();
-            if (message->type == messageType && message->id == messageId) {
-                matchingMessage = std::move(*i);
-                mailbox.erase(i);
-                break;
+std::unique_ptr<Message> ProcessControlBlock::getMessage() {
+    return std::unique_ptr<Message>(nextMessage(true));
+}
+
+// Get the next message. If there is none and the timeout expires first, a
+// message of type Timeout is returned.
+std::unique_ptr<Message> ProcessControlBlock::getMessage(
+    int timeoutMilliseconds) {
+
+    Message* message = nextMessage(false);
+    if (message == nullptr && timeoutMilliseconds > 0) {
+        startTimeout(timeoutMilliseconds);
+        message = nextMessage(true);
+        stopTimeout();
+        if (message->type == MessageType::Timeout) {
+            // Stale timeouts are never handed out, so this is ours.
+            delete message;
+            message = nullptr;
+        }
+    }
+    if (message == nullptr) {
+        message = new Message(MessageType::Timeout);
+    }
+    return std::unique_ptr<Message>(message);
+}
+
+// A message handler that receives messages itself must see the messages the
+// run loop has taken but not yet handled, so they are put back in front of
+// the deferred messages and the pending replies. They are then handed out one
+// by one, in the same order as before. The calls among them are still counted
+// as queued, and nextMessage() counts them off when it hands them out.
+void ProcessControlBlock::returnTakenMessages() {
+    if (nextTakenMessage == takenMessages.size()) {
+        return;
+    }
+
+    for (size_t i = nextTakenMessage; i < takenMessages.size(); i++) {
+        Message* message = takenMessages[i];
+        if (PendingReplyTable::isReply(message->type)) {
+            pendingReplies.insert(message);
+        }
+    }
+    for (size_t i = takenMessages.size(); i > nextTakenMessage; i--) {
+        Message* message = takenMessages[i - 1];
+        if (!PendingReplyTable::isReply(message->type)) {
+            deferredMessages.pushFront(message);
+        }
+    }
+    takenMessages.clear();
+    nextTakenMessage = 0;
+}
+
+Message* ProcessControlBlock::nextMessage(bool block) {
+    returnTakenMessages();
+    while (true) {
+        Message* message = nullptr;
+        if (!deferredMessages.isEmpty() &&
+            (pendingReplies.isEmpty() ||
+             deferredMessages.front()->_enqueueTime <=
+                 pendingReplies.getOldestArrival())) {
+            message = deferredMessages.popFront();
+        } else if (!pendingReplies.isEmpty()) {
+            // Replies nobody asked for are handed out here so that they do not
+            // pile up. They come in the order they arrived, along with the
+            // deferred messages.
+            message = pendingReplies.removeOldest();
+        } else {
+            message = block ? receiveMessage() : takeFromMailbox();
+            if (message == nullptr) {
+                return nullptr;
+            }
+            if (isStaleTimeout(message)) {
+                delete message;
+                continue;
+            }
+        }
+
+        if (message->type == MessageType::MethodCall) {
+            int queued = queuedCalls.fetch_sub(1, std::memory_order_relaxed);
+            if (mailboxLimit.capacity > 0 &&
+                mailboxLimit.overflowPolicy == MailboxOverflow::DropOldest &&
+                queued > mailboxLimit.capacity) {
+                // More calls have arrived than the mailbox can hold. This is
+                // the oldest of them, so it is the one to drop.
+                delete message;
+                continue;
+            }
+        }
+        return message;
+    }
+}
+
+// Take up to max messages, in the order getMessage() would hand them out.
+// If block is set, wait for the first one. The messages that are already in
+// the mailbox after the first one are taken together, so that the clock is
+// read and the queued call count is updated once for all of them.
+void ProcessControlBlock::takeMessages(
+    std::vector<Message*>& batch,
+    size_t max,
+    bool block) {
+
+    Message* first = nextMessage(block);
+    if (first == nullptr) {
+        return;
+    }
+    batch.push_back(first);
+
+    while (batch.size() < max &&
+           (!deferredMessages.isEmpty() || !pendingReplies.isEmpty())) {
+        Message* message = nextMessage(false);
+        if (message == nullptr) {
+            return;
+        }
+        batch.push_back(message);
+    }
+
+    size_t start = batch.size();
+    while (batch.size() < max) {
+        Message* message = mailbox.pop();
+        if (message == nullptr) {
+            break;
+        }
+        if (isStaleTimeout(message)) {
+            delete message;
+            continue;
+        }
+        batch.push_back(message);
+    }
+    if (batch.size() == start) {
+        return;
+    }
+
+    long long now = toNanoseconds(Clock::now());
+    int calls = 0;
+    for (size_t i = start; i < batch.size(); i++) {
+        countReceived(batch[i], now);
+        if (batch[i]->type == MessageType::MethodCall) {
+            calls++;
+        }
+    }
+    if (calls == 0) {
+        return;
+    }
+
+    int queued = queuedCalls.fetch_sub(calls, std::memory_order_relaxed);
+    if (mailboxLimit.capacity > 0 &&
+        mailboxLimit.overflowPolicy == MailboxOverflow::DropOldest) {
+        // Drop the oldest calls, just like nextMessage() does.
+        size_t kept = start;
+        for (size_t i = start; i < batch.size(); i++) {
+            Message* message = batch[i];
+            if (message->type == MessageType::MethodCall) {
+                bool drop = queued > mailboxLimit.capacity;
+                queued--;
+                if (drop) {
+                    delete message;
+                    continue;
+                }
+            }
+            batch[kept++] = message;
+        }
+        batch.resize(kept);
+    }
+}
+
+std::unique_ptr<Message> ProcessControlBlock::getMessage(
+    int messageType,
+    int messageId) {
+
+    returnTakenMessages();
+    Message* matchingMessage = nullptr;
+    if (PendingReplyTable::isReply(messageType)) {
+        matchingMessage = pendingReplies.remove(messageType, messageId);
+    } else {
+        matchingMessage = deferredMessages.remove(messageType, messageId);
+    }
+
+    while (matchingMessage == nullptr) {
+        Message* message = receiveMessage();
+        if (message->type == messageType && message->id == messageId) {
+            matchingMessage = message;
+        } else if (message->type == MessageType::Timeout) {
+            if (isStaleTimeout(message)) {
+                delete message;
+            } else {
+                // The timeout of waitForReply() expired.
+                matchingMessage = message;
+            }
+        } else {
+            sortOut(message);
+        }
+    }
+    if (matchingMessage->type == MessageType::MethodCall) {
+        queuedCalls.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return std::unique_ptr<Message>(matchingMessage);
+}
+
+bool ProcessControlBlock::hasReply(int messageType, int messageId) {
+    returnTakenMessages();
+
+    // Sort out what has arrived so far without waiting. Messages that are not
+    // replies keep their order in the deferred queue, which is always served
+    // before the mailbox.
+    while (Message* message = takeFromMailbox()) {
+        if (isStaleTimeout(message)) {
+            delete message;
+        } else {
+            sortOut(message);
+        }
+    }
+    return pendingReplies.contains(messageType, messageId);
+}
+
+// Wait until a reply of the given type and ID has been received, but at most
+// for the given time. The reply is kept so that it can be fetched by
+// getMessage() later. Returns false if the timeout expired first.
+bool ProcessControlBlock::waitForReply(
+    int messageType,
+    int messageId,
+    int timeoutMilliseconds) {
+
+    if (hasReply(messageType, messageId)) {
+        return true;
+    }
+    if (timeoutMilliseconds <= 0) {
+        return false;
+    }
+
+    startTimeout(timeoutMilliseconds);
+    auto reply = getMessage(messageType, messageId);
+    stopTimeout();
+    if (reply->type == MessageType::Timeout) {
+        return false;
+    }
+    pendingReplies.insert(reply.release());
+    return true;
+}
+
+void ProcessControlBlock::sortOut(Message* message) {
+    if (PendingReplyTable::isReply(message->type)) {
+        pendingReplies.insert(message);
+    } else {
+        deferredMessages.pushBack(message);
+    }
+}
+
+void ProcessControlBlock::startTimeout(int milliseconds) {
+    auto timeout = make_unique<Message>(MessageType::Timeout);
+    timeout->id = kernel.allocateMessageId();
+    activeTimeoutId = timeout->id;
+    timeoutTimerId = timerWheel.start(milliseconds, pid, std::move(timeout));
+}
+
+void ProcessControlBlock::stopTimeout() {
+    // If the timer has already fired, the timeout message is dropped when it
+    // is received, since it is no longer the active timeout.
+    timerWheel.cancel(timeoutTimerId);
+    activeTimeoutId = 0;
+    timeoutTimerId = 0;
+}
+
+Message* ProcessControlBlock::receiveMessage() {
+    while (true) {
+        Message* message = takeFromMailbox();
+        if (message != nullptr) {
+            return message;
+        }
+        waitForMessage();
+    }
+}
+
+Message* ProcessControlBlock::takeFromMailbox() {
+    Message* message = mailbox.pop();
+    if (message != nullptr) {
+        countReceived(message, toNanoseconds(Clock::now()));
+    }
+    return message;
+}
+
+void ProcessControlBlock::countReceived(const Message* message, long long now) {
+    if (tracer.isEnabled()) {
+        tracer.record(TraceDequeue,
+                      pid,
+                      0,
+                      message->type,
+                      message->id,
+                      message->interfaceId);
+    }
+    ProcessCounters::add(counters.messagesReceived, 1);
+
+    long long delay = (now - message->_enqueueTime) / 1000;
+    int bucket = 0;
+    if (delay > 0) {
+        // The number of significant bits is the smallest i such that the
+        // delay is less than 2^i.
+        bucket = 64 - __builtin_clzll(delay);
+        if (bucket >= queueingDelayBucketCount) {
+            bucket = queueingDelayBucketCount - 1;
+        }
+    }
+    ProcessCounters::add(counters.queueingDelays[bucket], 1);
+}
+
+void ProcessControlBlock::getMetrics(ProcessMetricsSnapshot& metrics) const {
+    metrics.pid = pid;
+    metrics.name = name;
+    metrics.messagesReceived = ProcessCounters::read(counters.messagesReceived);
+    metrics.messagesSent = ProcessCounters::read(counters.messagesSent);
+    metrics.mailboxLength = getMailboxLength();
+    metrics.mailboxHighWaterMark = getMailboxHighWaterMark();
+    metrics.handlingNanoseconds =
+        ProcessCounters::read(counters.handlingNanoseconds);
+    for (int i = 0; i < queueingDelayBucketCount; i++) {
+        metrics.queueingDelays[i] =
+            ProcessCounters::read(counters.queueingDelays[i]);
+    }
+}
+
+void ProcessControlBlock::waitForMessage() {
+    if (worker == nullptr) {
+        for (int i = 0; i < mailboxSpinCount; i++) {
+            if (!mailbox.isEmpty()) {
+                return;
+            }
+            spinPause();
+        }
+
+        // The sender checks the wakeup state after adding the message, so
+        // either we see the message here or the sender sees that we are
+        // parked and wakes us up.
+        wakeupState.store(Parked);
+        if (mailbox.isEmpty()) {
+            futexWait(&wakeupState, Parked);
+        }
+        wakeupState.store(Running);
+    } else {
+        // Park the coroutine instead of blocking the worker thread. The
+        // process is bound to this worker, so it cannot be resumed before it
+        // has been switched out, even if it is scheduled right away.
+        wakeupState.store(Parked);
+        if (!mailbox.isEmpty() && wakeupState.exchange(Running) == Parked) {
+            return;
+        }
+
+        // Either the mailbox is empty or a sender has already seen that we
+        // are parked and will schedule us.
+        worker->suspend(this);
+    }
+}
+
+void ProcessControlBlock::notify() {
+    if (wakeupState.exchange(Running) == Parked) {
+        if (worker == nullptr) {
+            futexWake(&wakeupState);
+        } else if (!worker->handOff(this)) {
+            worker->schedule(this);
+        }
+    }
+}
+
+Mailbox::Mailbox() : head(&stub), tail(&stub), stub(MessageType::Terminate) {
+    setNext(&stub, nullptr);
+}
+
+Mailbox::~Mailbox() {
+    while (Message* message = pop()) {
+        delete message;
+    }
+}
+
+void Mailbox::push(Message* message) {
+    setNext(message, nullptr);
+    Message* previous = head.exchange(message);
+    setNext(previous, message);
+}
+
+// Add a chain of messages that are already linked to each other, with a
+// single atomic exchange.
+void Mailbox::push(Message* first, Message* last) {
+    setNext(last, nullptr);
+    Message* previous = head.exchange(last);
+    setNext(previous, first);
+}
+
+Message* Mailbox::pop() {
+    Message* message = tail;
+    Message* next = getNext(message);
+    if (message == &stub) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        tail = next;
+        message = next;
+        next = getNext(next);
+    }
+    if (next != nullptr) {
+        tail = next;
+        return message;
+    }
+    if (message != head.load()) {
+        // A producer is in the middle of adding a message.
+        return nullptr;
+    }
+
+    // The message is the last one in the queue. Put back the stub so that
+    // the message can be unlinked.
+    push(&stub);
+    next = getNext(message);
+    if (next != nullptr) {
+        tail = next;
+        return message;
+    }
+    return nullptr;
+}
+
+DeferredMessageQueue::~DeferredMessageQueue() {
+    while (Message* message = popFront()) {
+        delete message;
+    }
+}
+
+void DeferredMessageQueue::pushBack(Message* message) {
+    setNext(message, nullptr);
+    if (last == nullptr) {
+        first = message;
+    } else {
+        setNext(last, message);
+    }
+    last = message;
+}
+
+void DeferredMessageQueue::pushFront(Message* message) {
+    setNext(message, first);
+    if (first == nullptr) {
+        last = message;
+    }
+    first = message;
+}
+
+Message* DeferredMessageQueue::popFront() {
+    Message* message = first;
+    if (message != nullptr) {
+        first = getNext(message);
+        if (first == nullptr) {
+            last = nullptr;
+        }
+    }
+    return message;
+}
+
+Message* DeferredMessageQueue::remove(int messageType, int messageId) {
+    Message* previous = nullptr;
+    for (Message* message = first;
+         message != nullptr;
+         message = getNext(message)) {
+        if (message->type == messageType && message->id == messageId) {
+            Message* next = getNext(message);
+            if (previous == nullptr) {
+                first = next;
+            } else {
+                setNext(previous, next);
+            }
+            if (last == message) {
+                last = previous;
             }
+            return message;
         }
-        if (matchingMessage) {
+        previous = message;
+    }
+    return nullptr;
+}
+
+PendingReplyTable::~PendingReplyTable() {
+    for (auto& entry: arrivals) {
+        delete entry.second;
+    }
+}
+
+void PendingReplyTable::insert(Message* message) {
+    auto arrival = arrivals.insert(std::make_pair(message->_enqueueTime,
+                                                  message));
+    replies.insert(std::make_pair(makeKey(message->type, message->id),
+                                  arrival));
+}
+
+Message* PendingReplyTable::remove(int messageType, int messageId) {
+    auto i = replies.find(makeKey(messageType, messageId));
+    if (i == replies.end()) {
+        return nullptr;
+    }
+    Message* message = i->second->second;
+    arrivals.erase(i->second);
+    replies.erase(i);
+    return message;
+}
+
+Message* PendingReplyTable::removeOldest() {
+    auto arrival = arrivals.begin();
+    Message* message = arrival->second;
+    auto range = replies.equal_range(makeKey(message->type, message->id));
+    for (auto i = range.first; i != range.second; ++i) {
+        if (i->second == arrival) {
+            replies.erase(i);
             break;
         }
-        condition.wait(lock);
     }
-    return matchingMessage;
+    arrivals.erase(arrival);
+    return message;
+}
+
+Worker::Worker(int c, int n, int id) :
+    thread(),
+    mutex(),
+    condition(),
+    runQueue(),
+    sleepQueue(),
+    stackPool(),
+    retiredStack(nullptr),
+    schedulerContext(),
+    handoffProcess(nullptr),
+    handoffCount(0),
+    cpu(c),
+    node(n),
+    nodeId(id) {}
+
+void Worker::start() {
+    thread = std::thread(&Worker::run, this);
+    setThreadAffinity(thread, std::vector<int>(1, cpu));
+    thread.detach();
+}
+
+void Worker::schedule(ProcessControlBlock* process) {
+    std::lock_guard<std::mutex> lock(mutex);
+    runQueue.push_back(process);
+    condition.notify_one();
+}
+
+// Take over the scheduling of a process that the running process has woken
+// up, so that the worker can switch straight to it once the running process
+// suspends itself, without a trip through the run queue. A synchronous call
+// between two processes of the same worker then costs one switch each way.
+// Returns false if the process must be scheduled the normal way.
+bool Worker::handOff(ProcessControlBlock* process) {
+    // The current process is only set on the thread of its worker, so this
+    // is only true on our own thread.
+    if (currentProcess == nullptr ||
+        currentProcess->getWorker() != this ||
+        handoffProcess != nullptr ||
+        handoffCount >= maxConsecutiveHandoffs) {
+        return false;
+    }
+    handoffProcess = process;
+    return true;
+}
+
+void Worker::suspend(ProcessControlBlock* process) {
+    ProcessControlBlock* next = handoffProcess;
+    if (next == nullptr) {
+        swapcontext(process->getContext(), &schedulerContext);
+        return;
+    }
+
+    handoffProcess = nullptr;
+    handoffCount++;
+    currentProcess = next;
+    ProcessLocalStorage::current() = next->getStatics();
+    Region::current() = next->getActiveRegion();
+    swapcontext(process->getContext(), next->getContext());
+
+    // Whoever switched back to this process has made it the current process
+    // again.
+}
+
+void Worker::sleep(ProcessControlBlock* process, int milliseconds) {
+    // The sleep queue is only accessed from the worker thread, so no locking
+    // is needed.
+    sleepQueue.insert(
+        std::make_pair(Clock::now() + std::chrono::milliseconds(milliseconds),
+                       process));
+    suspend(process);
+}
+
+void Worker::releaseStack(void* stack) {
+    if (stackPool.size() < maxPooledStacks) {
+        stackPool.push_back(stack);
+    } else {
+        munmap(stack, coroutineStackSize);
+    }
+}
+
+void Worker::run() {
+    while (true) {
+        resume(getNextProcess());
+    }
+}
+
+ProcessControlBlock* Worker::getNextProcess() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        auto now = Clock::now();
+        while (!sleepQueue.empty() && sleepQueue.begin()->first <= now) {
+            runQueue.push_back(sleepQueue.begin()->second);
+            sleepQueue.erase(sleepQueue.begin());
+        }
+        if (!runQueue.empty()) {
+            break;
+        }
+        if (sleepQueue.empty()) {
+            condition.wait(lock);
+        } else {
+            condition.wait_until(lock, sleepQueue.begin()->first);
+        }
+    }
+
+    ProcessControlBlock* process = runQueue.front();
+    runQueue.pop_front();
+    return process;
+}
+
+void Worker::resume(ProcessControlBlock* process) {
+    if (process->getStack() == nullptr) {
+        // First time the process is scheduled. Create the coroutine.
+        void* stack = allocateStack();
+        process->setStack(stack);
+        ucontext_t* context = process->getContext();
+        getcontext(context);
+        context->uc_stack.ss_sp = stack;
+        context->uc_stack.ss_size = coroutineStackSize;
+        context->uc_link = &schedulerContext;
+        makecontext(context, coroutineEntryPoint, 0);
+    }
+
+    currentProcess = process;
+    ProcessLocalStorage::current() = process->getStatics();
+    Region::current() = process->getActiveRegion();
+    handoffCount = 0;
+    swapcontext(&schedulerContext, process->getContext());
+    currentProcess = nullptr;
+    ProcessLocalStorage::current() = nullptr;
+    Region::current() = nullptr;
+
+    if (retiredStack != nullptr) {
+        releaseStack(retiredStack);
+        retiredStack = nullptr;
+    }
+    if (handoffProcess != nullptr) {
+        // The process that woke it up terminated instead of suspending
+        // itself.
+        schedule(handoffProcess);
+        handoffProcess = nullptr;
+    }
+}
+
+void* Worker::allocateStack() {
+    if (!stackPool.empty()) {
+        void* stack = stackPool.back();
+        stackPool.pop_back();
+        return stack;
+    }
+
+    void* stack = mmap(nullptr,
+                       coroutineStackSize,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                       -1,
+                       0);
+    if (stack == MAP_FAILED) {
+        printf("\nFailed to allocate process stack\n");
+        abort();
+    }
+
+    // Keep the stack in the memory of the NUMA node of the worker, even if
+    // the node is short of memory when the pages are first touched. The call
+    // fails harmlessly on systems without NUMA support.
+    unsigned long nodeMask = 0;
+    if (nodeId >= 0 && nodeId < static_cast<int>(sizeof(nodeMask) * 8)) {
+        nodeMask = 1UL << nodeId;
+        syscall(SYS_mbind,
+                stack,
+                coroutineStackSize,
+                memoryPolicyPreferred,
+                &nodeMask,
+                sizeof(nodeMask) * 8,
+                0);
+    }
+
+    // The lowest page is a guard page that catches stack overflows.
+    mprotect(stack, sysconf(_SC_PAGESIZE), PROT_NONE);
+    return stack;
 }
 
 Kernel::Kernel() :
-    processMap(),
+    processTable(),
     nameToProcessMap(),
+    nameMutex(),
+    groups(),
+    groupMutex(),
     pidCounter(0),
-    messageIdCounter(0),
-    mutex() {
+    messageIdCounter(1),
+    nodeId(0),
+    topology(),
+    workers(),
+    nodeWorkers(),
+    nextWorker(0),
+    nextNode(0) {
+
+    // Without a valid node ID the executable runs on its own, as if
+    // BUHRLANG_NODE was not set.
+    const char* nodeStr = getenv("BUHRLANG_NODE");
+    if (nodeStr != nullptr) {
+        char* end = nullptr;
+        long node = strtol(nodeStr, &end, 10);
+        if (end == nodeStr || *end != '\0' || node < 1 || node > maxNodeId) {
+            fprintf(stderr,
+                    "BUHRLANG_NODE must be between 1 and %d.\n",
+                    maxNodeId);
+        } else {
+            nodeId = static_cast<int>(node);
+        }
+    }
 
-    auto rootProcess = make_unique<ProcessControlBlock>(0, 0, "root");
+    int rootPid = nodeId << nodeIdShift;
+    auto rootProcess =
+        make_unique<ProcessControlBlock>(rootPid, rootPid, "root");
     currentProcess = rootProcess.get();
-    processMap.insert(std::make_pair(0, std::move(rootProcess)));
+    ProcessLocalStorage::current() = rootProcess->getStatics();
+    insertProcess(std::move(rootProcess));
+
+    // Block the metrics dump signal before any other thread is started, so
+    // that every thread inherits the blocked signal and only the dumper
+    // thread receives it.
+    startMetricsDumper();
+
+    const char* scheduler = getenv("BUHRLANG_SCHEDULER");
+    if (scheduler != nullptr && std::string(scheduler) == "workers") {
+        startWorkers();
+    }
+}
+
+CpuTopology::CpuTopology() : nodes(), cpus() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        unsigned int cpuCount = std::thread::hardware_concurrency();
+        for (unsigned int cpu = 0; cpu < cpuCount || cpu == 0; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    const std::string nodeDirectory = "/sys/devices/system/node";
+    if (DIR* directory = opendir(nodeDirectory.c_str())) {
+        while (struct dirent* entry = readdir(directory)) {
+            int nodeId = 0;
+            if (sscanf(entry->d_name, "node%d", &nodeId) != 1) {
+                continue;
+            }
+            std::string fileName =
+                nodeDirectory + "/" + entry->d_name + "/cpulist";
+            FILE* file = fopen(fileName.c_str(), "r");
+            if (file == nullptr) {
+                continue;
+            }
+            char list[4096];
+            if (fgets(list, sizeof(list), file) != nullptr) {
+                Node node;
+                node.id = nodeId;
+                for (int cpu: parseCpuList(list)) {
+                    if (std::find(cpus.begin(), cpus.end(), cpu) !=
+                        cpus.end()) {
+                        node.cpus.push_back(cpu);
+                    }
+                }
+                if (!node.cpus.empty()) {
+                    nodes.push_back(node);
+                }
+            }
+            fclose(file);
+        }
+        closedir(directory);
+    }
+
+    if (nodes.empty()) {
+        Node node;
+        node.id = 0;
+        node.cpus = cpus;
+        nodes.push_back(node);
+    }
+    std::sort(nodes.begin(),
+              nodes.end(),
+              [](const Node& a, const Node& b) { return a.id < b.id; });
+}
+
+int CpuTopology::getNodeOfCpu(int cpu) const {
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const std::vector<int>& nodeCpus = nodes[i].cpus;
+        if (std::find(nodeCpus.begin(), nodeCpus.end(), cpu) !=
+            nodeCpus.end()) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Parse a CPU list like "0-3,8,10-11".
+std::vector<int> CpuTopology::parseCpuList(const char* list) {
+    std::vector<int> result;
+    const char* position = list;
+    while (*position != '\0') {
+        char* end = nullptr;
+        long first = strtol(position, &end, 10);
+        if (end == position) {
+            break;
+        }
+        long last = first;
+        position = end;
+        if (*position == '-') {
+            last = strtol(position + 1, &end, 10);
+            position = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            result.push_back(cpu);
+        }
+        if (*position != ',') {
+            break;
+        }
+        position++;
+    }
+    return result;
+}
+
+void Kernel::startMetricsDumper() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, metricsDumpSignal);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::thread(&Kernel::dumpMetricsOnSignal, this).detach();
+}
+
+// Print the metrics of all live processes to stderr every time the process
+// gets the metrics dump signal.
+void Kernel::dumpMetricsOnSignal() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, metricsDumpSignal);
+
+    std::vector<ProcessMetricsSnapshot> metrics;
+    while (true) {
+        int signal = 0;
+        if (sigwait(&signals, &signal) != 0) {
+            continue;
+        }
+
+        metrics.clear();
+        getMetrics(metrics);
+        fprintf(stderr,
+                "%8s %-16s %12s %12s %8s %8s %12s %10s %10s\n",
+                "PID",
+                "NAME",
+                "RECEIVED",
+                "SENT",
+                "MAILBOX",
+                "PEAK",
+                "HANDLING_MS",
+                "P50_US",
+                "P99_US");
+        for (const auto& process: metrics) {
+            fprintf(stderr,
+                    "%8d %-16s %12lld %12lld %8d %8d %12lld %10lld %10lld\n",
+                    process.pid,
+                    process.name.c_str(),
+                    process.messagesReceived,
+                    process.messagesSent,
+                    process.mailboxLength,
+                    process.mailboxHighWaterMark,
+                    process.handlingNanoseconds / 1000000,
+                    getQueueingDelayPercentile(process, 50),
+                    getQueueingDelayPercentile(process, 99));
+        }
+        fflush(stderr);
+    }
+}
+
+void Kernel::startWorkers() {
+    unsigned int workerCount = topology.getCpus().size();
+    const char* workersStr = getenv("BUHRLANG_WORKERS");
+    if (workersStr != nullptr) {
+        workerCount = atoi(workersStr);
+    }
+    if (workerCount == 0) {
+        workerCount = 1;
+    }
+
+    // The workers are never deleted since they may still be running processes
+    // when the program exits. Each worker is pinned to a CPU of its own, as
+    // long as there are enough CPUs.
+    const std::vector<int>& cpus = topology.getCpus();
+    nodeWorkers.resize(topology.getNodeCount());
+    for (unsigned int i = 0; i < workerCount; i++) {
+        int cpu = cpus[i % cpus.size()];
+        int node = topology.getNodeOfCpu(cpu);
+        Worker* worker = new Worker(cpu, node, topology.getNodeId(node));
+        worker->start();
+        workers.push_back(worker);
+        nodeWorkers[node].push_back(worker);
+    }
+}
+
+// Select the worker that is to run a process spawned by the current process.
+Worker* Kernel::selectWorker(const Placement& placement) {
+    if (placement.policy == ProcessPlacement::Pinned) {
+        for (auto worker: workers) {
+            if (worker->getCpu() == placement.core) {
+                return worker;
+            }
+        }
+        return workers[placement.core % workers.size()];
+    } else if (placement.policy == ProcessPlacement::WithParent &&
+               currentProcess->getWorker() != nullptr) {
+        return currentProcess->getWorker();
+    } else if (placement.policy == ProcessPlacement::NearParent ||
+               placement.policy == ProcessPlacement::WithParent) {
+        return selectNodeWorker(getCurrentNode());
+    } else if (placement.policy == ProcessPlacement::Spread) {
+        return selectNodeWorker(nextNode++ % nodeWorkers.size());
+    }
+    return workers[nextWorker++ % workers.size()];
+}
+
+Worker* Kernel::selectNodeWorker(int node) {
+    const std::vector<Worker*>& candidates = nodeWorkers[node];
+    if (candidates.empty()) {
+        return workers[nextWorker++ % workers.size()];
+    }
+    return candidates[nextWorker++ % candidates.size()];
+}
+
+// Select the CPUs that the thread of a process spawned by the current process
+// may run on. No CPUs means anywhere.
+std::vector<int> Kernel::selectCpus(const Placement& placement) {
+    if (placement.policy == ProcessPlacement::Pinned) {
+        return std::vector<int>(1, placement.core);
+    } else if (placement.policy == ProcessPlacement::NearParent ||
+               placement.policy == ProcessPlacement::WithParent) {
+        return topology.getNodeCpus(getCurrentNode());
+    } else if (placement.policy == ProcessPlacement::Spread) {
+        return topology.getNodeCpus(nextNode++ % topology.getNodeCount());
+    }
+    return std::vector<int>();
+}
+
+// Return the index of the NUMA node the current process runs on.
+int Kernel::getCurrentNode() {
+    Worker* worker = currentProcess->getWorker();
+    if (worker != nullptr) {
+        return worker->getNode();
+    }
+    return topology.getNodeOfCpu(sched_getcpu());
 }
 
 int Kernel::spawnProcess(
@@ -260,60 +2098,413 @@ int Kernel::spawnProcess(
 
     ProcessControlBlock* process = nullptr;
     int pid = 0;
+    const MailboxLimit& mailboxLimit = currentProcess->getSpawnMailboxLimit();
+    bool regionAllocation = currentProcess->getSpawnRegionAllocation();
 
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-
-        if (!name.empty()) {
-            auto i = nameToProcessMap.find(name);
-            if (i != nameToProcessMap.end()) {
-                ProcessControlBlock* existingProcess = i->second;
-                return existingProcess->getPid();
-            }
-        }
-        pid = ++pidCounter;
+    if (name.empty()) {
+        pid = allocatePid();
         process = new ProcessControlBlock(pid, currentProcess->getPid(), name);
-        processMap.insert(
-            std::make_pair(pid, std::unique_ptr<ProcessControlBlock>(process)));
-        if (!name.empty()) {
-            nameToProcessMap.insert(std::make_pair(name, process));
+        process->setMailboxLimit(mailboxLimit);
+        process->setRegionAllocation(regionAllocation);
+        insertProcess(std::unique_ptr<ProcessControlBlock>(process));
+    } else {
+        // Hold the name lock while inserting the process so that two
+        // processes cannot be spawned under the same name.
+        std::lock_guard<std::mutex> lock(nameMutex);
+
+        auto i = nameToProcessMap.find(name);
+        if (i != nameToProcessMap.end()) {
+            ProcessControlBlock* existingProcess = i->second;
+            return existingProcess->getPid();
         }
+        pid = allocatePid();
+        process = new ProcessControlBlock(pid, currentProcess->getPid(), name);
+        process->setMailboxLimit(mailboxLimit);
+        process->setRegionAllocation(regionAllocation);
+        insertProcess(std::unique_ptr<ProcessControlBlock>(process));
+        nameToProcessMap.insert(std::make_pair(name, process));
     }
 
-    process->start(factory);
+    if (tracer.isEnabled()) {
+        tracer.recordSpawn(currentProcess->getPid(), pid, name);
+    }
+    const Placement& placement = currentProcess->getSpawnPlacement();
+    if (workers.empty()) {
+        process->start(factory, nullptr, selectCpus(placement));
+    } else {
+        process->start(factory, selectWorker(placement), std::vector<int>());
+    }
     return pid;
 }
 
+// Return the PID for a new process. The node ID, if any, is put in the upper
+// bits, and the process number wraps around within the lower bits.
+int Kernel::allocatePid() {
+    int number = ++pidCounter;
+    if (nodeId == 0) {
+        return number;
+    }
+    return (nodeId << nodeIdShift) | (number & localPidMask);
+}
+
+void Kernel::insertProcess(std::unique_ptr<ProcessControlBlock> process) {
+    int pid = process->getPid();
+    ProcessTableShard& shard = getShard(pid);
+    std::lock_guard<ReadWriteSpinLock> lock(shard.lock);
+    shard.processMap.insert(std::make_pair(pid, std::move(process)));
+}
+
 int Kernel::sendMessage(int destinationPid, std::unique_ptr<Message> message) {
-    std::lock_guard<std::mutex> lock(mutex);
+    if (message->type == MessageType::MethodCall ||
+        message->type == MessageType::Terminate) {
+        message->id = allocateMessageId();
+    }
+    int messageId = message->id;
+    traceSend(destinationPid, message.get());
+    return deliverMessage(destinationPid, message) ? messageId : 0;
+}
 
-    PidToProcessMap::const_iterator i = processMap.find(destinationPid);
-    if (i != processMap.end()) {
-        ProcessControlBlock* process = i->second.get();
-        int messageType = message->type;
-        if (messageType == MessageType::MethodCall ||
-            messageType == MessageType::Terminate) {
-            message->id = messageIdCounter++;
+// Send a number of messages to the same process. The message IDs are
+// allocated together, and unless the mailbox limit of the receiver requires
+// the messages to be added one by one, the receiver is looked up once and
+// woken up once. Returns the number of messages that were sent, which are the
+// first ones of the vector. The ID of each message is stored in messageIds.
+int Kernel::sendMessages(
+    int destinationPid,
+    std::vector<std::unique_ptr<Message>>& messages,
+    std::vector<int>& messageIds) {
+
+    int idCount = 0;
+    for (auto& message: messages) {
+        if (message->type == MessageType::MethodCall ||
+            message->type == MessageType::Terminate) {
+            idCount++;
+        }
+    }
+    if (idCount > 0) {
+        int messageId =
+            messageIdCounter.fetch_add(idCount, std::memory_order_relaxed);
+        for (auto& message: messages) {
+            if (message->type == MessageType::MethodCall ||
+                message->type == MessageType::Terminate) {
+                message->id = messageId++;
+            }
+        }
+    }
+    for (auto& message: messages) {
+        messageIds.push_back(message->id);
+        traceSend(destinationPid, message.get());
+    }
+
+    bool ignoreLimit =
+        currentProcess == nullptr || destinationPid == currentProcess->getPid();
+    if (!isRemotePid(destinationPid)) {
+        ProcessTableShard& shard = getShard(destinationPid);
+        SharedLockGuard lock(shard.lock);
+
+        auto i = shard.processMap.find(destinationPid);
+        if (i == shard.processMap.end()) {
+            return 0;
+        }
+        int count = messages.size();
+        if (i->second->tryAddMessages(messages, ignoreLimit)) {
+            if (currentProcess != nullptr) {
+                currentProcess->countSent(count);
+            }
+            return count;
+        }
+    }
+
+    // The mailbox limit applies to each message, so send them one by one.
+    // Messages to another executable are also sent one by one, but the link
+    // to the executable writes them out together.
+    int sent = 0;
+    for (auto& message: messages) {
+        if (!deliverMessage(destinationPid, message)) {
+            break;
+        }
+        sent++;
+    }
+    return sent;
+}
+
+// Add a message to the mailbox of a process, waiting for room in the mailbox
+// if the mailbox limit of the receiver says so. Returns false if the message
+// could not be added, in which case the message is left with the caller.
+bool Kernel::deliverMessage(
+    int destinationPid,
+    std::unique_ptr<Message>& message) {
+
+    if (isRemotePid(destinationPid)) {
+        if (!nodeNetwork.send(destinationPid, *message)) {
+            return false;
+        }
+        message.reset();
+        if (currentProcess != nullptr) {
+            currentProcess->countSent(1);
+        }
+        return true;
+    }
+
+    // A process that sends to itself would wait forever for room in its own
+    // mailbox, and the timer thread, which is not a process, must never wait
+    // for a process.
+    bool ignoreLimit =
+        currentProcess == nullptr || destinationPid == currentProcess->getPid();
+    return deliverLocalMessage(destinationPid, message, ignoreLimit);
+}
+
+// Add a message to the mailbox of a local process. Returns false if there is
+// no such process, or if the mailbox is full and the overflow policy is to
+// fail the send.
+bool Kernel::deliverLocalMessage(
+    int destinationPid,
+    std::unique_ptr<Message>& message,
+    bool ignoreLimit) {
+
+    ProcessTableShard& shard = getShard(destinationPid);
+
+    for (int attempt = 0; ; attempt++) {
+        int overflowPolicy = MailboxOverflow::Fail;
+        {
+            // The shard is locked for reading while the message is added,
+            // which keeps the process from being deleted under our feet.
+            SharedLockGuard lock(shard.lock);
+
+            auto i = shard.processMap.find(destinationPid);
+            if (i == shard.processMap.end()) {
+                return false;
+            }
+            ProcessControlBlock* process = i->second.get();
+            if (process->tryAddMessage(message, ignoreLimit)) {
+                if (currentProcess != nullptr) {
+                    currentProcess->countSent(1);
+                }
+                return true;
+            }
+            overflowPolicy = process->getMailboxLimit().overflowPolicy;
+        }
+
+        if (overflowPolicy != MailboxOverflow::Block) {
+            return false;
+        }
+
+        // Wait outside of the lock, since the receiver may need to take
+        // the lock for writing before it gets around to empty its mailbox.
+        waitForMailboxSpace(attempt);
+    }
+}
+
+// Add a message that was sent by a process in another executable to the
+// mailbox of a local process. The message keeps the ID given to it by the
+// sender, since that is the ID the sender waits for a result with. Returns
+// false if there is no such process, or if the message was dropped.
+//
+// The mailbox limit of the receiver applies. If the policy is to block, the
+// thread that reads from the other executable waits, which in turn holds
+// back the sender once the socket or the ring is full. Otherwise the call is
+// dropped, since the sender cannot be told that the send failed.
+bool Kernel::deliverRemoteMessage(
+    int destinationPid,
+    std::unique_ptr<Message> message) {
+
+    if (isRemotePid(destinationPid)) {
+        return false;
+    }
+    traceSend(destinationPid, message.get());
+    return deliverLocalMessage(destinationPid, message, false);
+}
+
+void Kernel::traceSend(int destinationPid, const Message* message) {
+    if (tracer.isEnabled()) {
+        // Messages sent by the runtime itself, like timer messages, are
+        // shown as sent by PID -1.
+        tracer.record(TraceSend,
+                      currentProcess != nullptr ? currentProcess->getPid() : -1,
+                      destinationPid,
+                      message->type,
+                      message->id,
+                      message->interfaceId);
+    }
+}
+
+int Kernel::allocateMessageId() {
+    return messageIdCounter.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Kernel::waitForMailboxSpace(int attempt) {
+    // Give the receiver a chance to catch up. First just yield, then back
+    // off to sleeping so that a long stall does not burn a core.
+    int milliseconds = attempt < mailboxYieldCount ? 0 : 1;
+    Worker* worker =
+        currentProcess != nullptr ? currentProcess->getWorker() : nullptr;
+    if (worker != nullptr) {
+        worker->sleep(currentProcess, milliseconds);
+    } else if (milliseconds == 0) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+}
+
+int Kernel::getMailboxHighWaterMark(int pid) {
+    ProcessTableShard& shard = getShard(pid);
+    SharedLockGuard lock(shard.lock);
+
+    auto i = shard.processMap.find(pid);
+    if (i == shard.processMap.end()) {
+        return -1;
+    }
+    return i->second->getMailboxHighWaterMark();
+}
+
+int Kernel::getMailboxLength(int pid) {
+    ProcessTableShard& shard = getShard(pid);
+    SharedLockGuard lock(shard.lock);
+
+    auto i = shard.processMap.find(pid);
+    if (i == shard.processMap.end()) {
+        return -1;
+    }
+    return i->second->getMailboxLength();
+}
+
+void Kernel::getMetrics(std::vector<ProcessMetricsSnapshot>& metrics) {
+    for (auto& shard: processTable) {
+        SharedLockGuard lock(shard.lock);
+
+        for (const auto& entry: shard.processMap) {
+            metrics.emplace_back();
+            entry.second->getMetrics(metrics.back());
         }
-        int messageId = message->id;
-        process->addMessage(std::move(message));
-        return messageId;
     }
-    return 0;
 }
 
 void Kernel::removeProcess(int pid) {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<ProcessControlBlock> process;
+    ProcessTableShard& shard = getShard(pid);
+
+    // Only the process itself removes its entry, so the name can be looked up
+    // before the entry is removed.
+    std::string processName;
+    {
+        SharedLockGuard lock(shard.lock);
+
+        auto i = shard.processMap.find(pid);
+        if (i == shard.processMap.end()) {
+            return;
+        }
+        processName = i->second->getName();
+    }
 
-    auto i = processMap.find(pid);
-    if (i != processMap.end()) {
-        ProcessControlBlock* process = i->second.get();
-        const std::string& processName = process->getName();
+    {
+        // The name of a named process is erased in the same critical section
+        // as its PID, so that spawnProcess() and findProcess() never return
+        // the PID of a process that is gone. The name lock is taken before
+        // the shard lock, as in spawnProcess().
+        std::unique_lock<std::mutex> nameLock(nameMutex, std::defer_lock);
         if (!processName.empty()) {
+            nameLock.lock();
             nameToProcessMap.erase(processName);
         }
-        processMap.erase(i);
+
+        std::lock_guard<ReadWriteSpinLock> lock(shard.lock);
+        auto i = shard.processMap.find(pid);
+        process = std::move(i->second);
+        shard.processMap.erase(i);
     }
+
+    if (!process->getGroups().empty()) {
+        std::lock_guard<std::mutex> lock(groupMutex);
+        for (const auto& group: process->getGroups()) {
+            removeGroupMember(group, pid);
+        }
+    }
+
+    // The process control block is deleted here, outside of the locks.
+}
+
+void Kernel::joinGroup(const std::string& group) {
+    auto& joinedGroups = currentProcess->getGroups();
+    if (std::find(joinedGroups.begin(), joinedGroups.end(), group) !=
+        joinedGroups.end()) {
+        return;
+    }
+    joinedGroups.push_back(group);
+
+    std::lock_guard<std::mutex> lock(groupMutex);
+    groups[group].push_back(currentProcess->getPid());
+}
+
+void Kernel::leaveGroup(const std::string& group) {
+    auto& joinedGroups = currentProcess->getGroups();
+    auto i = std::find(joinedGroups.begin(), joinedGroups.end(), group);
+    if (i == joinedGroups.end()) {
+        return;
+    }
+    joinedGroups.erase(i);
+
+    std::lock_guard<std::mutex> lock(groupMutex);
+    removeGroupMember(group, currentProcess->getPid());
+}
+
+void Kernel::removeGroupMember(const std::string& group, int pid) {
+    auto i = groups.find(group);
+    if (i == groups.end()) {
+        return;
+    }
+    auto& members = i->second;
+    members.erase(std::remove(members.begin(), members.end(), pid),
+                  members.end());
+    if (members.empty()) {
+        groups.erase(i);
+    }
+}
+
+// Send a message to every member of a group, and return the number of members
+// it was sent to. Every member gets its own copy of the data, just as if the
+// message had been sent to each member in turn.
+int Kernel::publish(const std::string& group, const Message& message) {
+    std::vector<int> members;
+    {
+        std::lock_guard<std::mutex> lock(groupMutex);
+        auto i = groups.find(group);
+        if (i == groups.end()) {
+            return 0;
+        }
+        members = i->second;
+    }
+
+    int sent = 0;
+    for (int pid: members) {
+        Pointer<_Cloneable> data;
+        if (message.data.get() != nullptr) {
+            data = dynamicPointerCast<_Cloneable>(message.data->_clone());
+        }
+        auto envelope = make_unique<Message>(message.type, data);
+        envelope->messageHandlerId = message.messageHandlerId;
+        envelope->interfaceId = message.interfaceId;
+        if (envelope->type == MessageType::MethodCall) {
+            envelope->id = allocateMessageId();
+        }
+        traceSend(pid, envelope.get());
+        if (deliverMessage(pid, envelope)) {
+            sent++;
+        }
+    }
+    return sent;
+}
+
+// Return the PID of the process of the given name, or 0 if there is no such
+// process.
+int Kernel::findProcess(const std::string& name) {
+    std::lock_guard<std::mutex> lock(nameMutex);
+
+    auto i = nameToProcessMap.find(name);
+    if (i == nameToProcessMap.end()) {
+        return 0;
+    }
+    return i->second->getPid();
 }
 
 void Kernel::waitForProcessTermination(int childPid) {
@@ -324,15 +2515,44 @@ void Kernel::waitForProcessTermination(int childPid) {
 }
 
 bool Kernel::isProcessAlive(int pid) {
-    bool result = false;
-    {
-        std::lock_guard<std::mutex> lock(mutex);
+    ProcessTableShard& shard = getShard(pid);
+    SharedLockGuard lock(shard.lock);
+    return shard.processMap.find(pid) != shard.processMap.end();
+}
 
-        if (processMap.find(pid) != processMap.end()) {
-            result = true;
+void ReadWriteSpinLock::lockShared() {
+    while (true) {
+        unsigned int current = state.fetch_add(1, std::memory_order_acquire);
+        if ((current & writerBit) == 0) {
+            return;
+        }
+
+        // A writer holds or waits for the lock. Back off until it is done.
+        state.fetch_sub(1, std::memory_order_relaxed);
+        while (state.load(std::memory_order_relaxed) & writerBit) {
+            std::this_thread::yield();
         }
     }
-    return result;
+}
+
+void ReadWriteSpinLock::lock() {
+    // Claim the writer bit, then wait for the readers to leave.
+    unsigned int current = state.load(std::memory_order_relaxed);
+    while (true) {
+        if ((current & writerBit) == 0 &&
+            state.compare_exchange_weak(current,
+                                        current | writerBit,
+                                        std::memory_order_acquire)) {
+            break;
+        }
+        if (current & writerBit) {
+            std::this_thread::yield();
+            current = state.load(std::memory_order_relaxed);
+        }
+    }
+    while (state.load(std::memory_order_acquire) != writerBit) {
+        std::this_thread::yield();
+    }
 }
 
 int Process::spawn(Pointer<MessageHandlerFactory> factory) {
@@ -354,7 +2574,7 @@ int Process::spawn(
 
     std::string nameStr;
     if (name.get() != nullptr) {
-        nameStr = std::string(name->buf->data(), name->buf->length());
+        nameStr = std::string(name->data(), name->length());
     }
     return kernel.spawnProcess(clonedFactoryRawPtr, nameStr);
 }
@@ -363,20 +2583,111 @@ int Process::registerMessageHandler(Pointer<MessageHandler> messageHandler) {
     return currentProcess->registerMessageHandler(messageHandler);
 }
 
-void Process::send(int destinationPid, Pointer<Message> message) {
-    // Clone the message so that the sending and receiving process don't share
-    // the message.
-    Pointer<Message> clonedMsg = dynamicPointerCast<Message>(message->_clone());
-
-    // Release the cloned message from the ref counted pointer so that the
-    // cloned message is not deleted once this method returns. The reference
-    // count for messages in the kernel is zero.
-    std::unique_ptr<Message> clonedMsgPtr(clonedMsg.release());
+namespace {
+    std::unique_ptr<Message> takeOrClone(Pointer<Message>& message) {
+        std::unique_ptr<Message> sentMsg;
+        if (message->_isUnique()) {
+            // Nothing but this pointer references the message or any object
+            // in it, so the sending process can't touch the message once it
+            // has been sent. Hand over the message as it is. Releasing the
+            // message from the ref counted pointer leaves the reference count
+            // at zero, which is the reference count for messages in the
+            // kernel.
+            sentMsg.reset(message.release());
+        } else {
+            // Clone the message so that the sending and receiving process
+            // don't share the message.
+            Pointer<Message> clonedMsg =
+                dynamicPointerCast<Message>(message->_clone());
+            sentMsg.reset(clonedMsg.release());
+        }
+        return sentMsg;
+    }
+}
 
+int Process::send(int destinationPid, Pointer<Message> message) {
+    std::unique_ptr<Message> sentMsg = takeOrClone(message);
     // Send the message.
     // Set the message ID filled in by the kernel so that the generated code can
     // receive a result message based on the message id in the request message.
-    message->id = kernel.sendMessage(destinationPid, std::move(clonedMsgPtr));
+    int messageId = kernel.sendMessage(destinationPid, std::move(sentMsg));
+    if (message.get() != nullptr) {
+        message->id = messageId;
+    }
+    return messageId;
+}
+
+int Process::sendBatch(
+    int destinationPid,
+    Pointer<Array<Pointer<Message> > > messages) {
+
+    // The messages can only be handed over if nothing but this pointer
+    // references the array. Otherwise the caller still sees them.
+    bool handOver = messages->_referenceCount() == 1;
+    std::vector<std::unique_ptr<Message>> sentMsgs;
+    sentMsgs.reserve(messages->length());
+    for (int i = 0; i < messages->length(); i++) {
+        Pointer<Message>& message = messages->at(i);
+        if (handOver) {
+            sentMsgs.push_back(takeOrClone(message));
+        } else {
+            Pointer<Message> copy(message);
+            sentMsgs.push_back(takeOrClone(copy));
+        }
+    }
+
+    std::vector<int> messageIds;
+    int sent = kernel.sendMessages(destinationPid, sentMsgs, messageIds);
+    for (int i = 0; i < messages->length(); i++) {
+        Pointer<Message>& message = messages->at(i);
+        if (message.get() != nullptr) {
+            message->id = i < sent ? messageIds[i] : 0;
+        }
+    }
+    return sent;
+}
+
+void Process::join(Pointer<string> group) {
+    kernel.joinGroup(std::string(group->data(), group->length()));
+}
+
+void Process::leave(Pointer<string> group) {
+    kernel.leaveGroup(std::string(group->data(), group->length()));
+}
+
+int Process::publish(Pointer<string> group, Pointer<Message> message) {
+    return kernel.publish(
+        std::string(group->data(), group->length()),
+        *message);
+}
+
+bool Process::listen(Pointer<string> socketPath) {
+    return nodeNetwork.listen(
+        std::string(socketPath->data(), socketPath->length()));
+}
+
+int Process::connect(Pointer<string> socketPath, Pointer<string> name) {
+    return nodeNetwork.connect(
+        std::string(socketPath->data(), socketPath->length()),
+        std::string(name->data(), name->length()));
+}
+
+int Process::getNode() {
+    return kernel.getNodeId();
+}
+
+int Process::sendAfter(
+    int destinationPid,
+    Pointer<Message> message,
+    int milliseconds) {
+
+    return timerWheel.start(milliseconds,
+                            destinationPid,
+                            takeOrClone(message));
+}
+
+bool Process::cancelTimer(int timerId) {
+    return timerWheel.cancel(timerId);
 }
 
 Pointer<Message> Process::receive() {
@@ -384,6 +2695,23 @@ Pointer<Message> Process::receive() {
     return message;
 }
 
+Pointer<Message> Process::receive(int timeoutMilliseconds) {
+    Pointer<Message> message(
+        currentProcess->getMessage(timeoutMilliseconds).release());
+    return message;
+}
+
+Pointer<Array<Pointer<Message> > > Process::receiveAll(int max) {
+    std::vector<Message*> batch;
+    currentProcess->takeMessages(batch, max > 0 ? max : 1, true);
+    Pointer<Array<Pointer<Message> > > messages(
+        new Array<Pointer<Message> >());
+    for (Message* message: batch) {
+        messages->append(Pointer<Message>(message));
+    }
+    return messages;
+}
+
 Pointer<Message> Process::receiveMethodResult(int messageId) {
     return receive(MessageType::MethodResult, messageId);
 }
@@ -394,6 +2722,16 @@ Pointer<Message> Process::receive(int messageType, int messageId) {
     return message;
 }
 
+bool Process::hasMethodResult(int messageId) {
+    return currentProcess->hasReply(MessageType::MethodResult, messageId);
+}
+
+bool Process::waitForMethodResult(int messageId, int timeoutMilliseconds) {
+    return currentProcess->waitForReply(MessageType::MethodResult,
+                                        messageId,
+                                        timeoutMilliseconds);
+}
+
 int Process::getPid() {
     return currentProcess->getPid();
 }
@@ -402,10 +2740,68 @@ void Process::terminate() {
     currentProcess->addMessage(make_unique<Message>(MessageType::Terminate));
 }
 
+void Process::terminate(int pid) {
+    kernel.sendMessage(pid, make_unique<Message>(MessageType::Terminate));
+}
+
 void Process::wait(int pid) {
     kernel.waitForProcessTermination(pid);
 }
 
+void Process::setSpawnPlacement(int placement, int core) {
+    currentProcess->setSpawnPlacement(Placement(placement, core));
+}
+
+void Process::setSpawnRegionAllocation(bool enabled) {
+    currentProcess->setSpawnRegionAllocation(enabled);
+}
+
+void Process::setSpawnMailboxLimit(int capacity, int overflowPolicy) {
+    currentProcess->setSpawnMailboxLimit(
+        MailboxLimit(capacity, overflowPolicy));
+}
+
+int Process::getMailboxHighWaterMark(int pid) {
+    return kernel.getMailboxHighWaterMark(pid);
+}
+
+int Process::getMailboxLength(int pid) {
+    return kernel.getMailboxLength(pid);
+}
+
+Pointer<Array<Pointer<ProcessMetrics> > > Process::getMetrics() {
+    std::vector<ProcessMetricsSnapshot> snapshots;
+    kernel.getMetrics(snapshots);
+
+    Pointer<Array<Pointer<ProcessMetrics> > > result(
+        new Array<Pointer<ProcessMetrics> >(snapshots.size()));
+    for (const auto& snapshot: snapshots) {
+        Pointer<Array<long long> > queueingDelays(
+            new Array<long long>(queueingDelayBucketCount));
+        for (auto count: snapshot.queueingDelays) {
+            queueingDelays->append(count);
+        }
+
+        Pointer<ProcessMetrics> metrics(new ProcessMetrics());
+        metrics->pid = snapshot.pid;
+        metrics->name = Utils::makeString(snapshot.name.data(),
+                                          snapshot.name.size());
+        metrics->messagesReceived = snapshot.messagesReceived;
+        metrics->messagesSent = snapshot.messagesSent;
+        metrics->mailboxLength = snapshot.mailboxLength;
+        metrics->mailboxHighWaterMark = snapshot.mailboxHighWaterMark;
+        metrics->handlingMicroseconds = snapshot.handlingNanoseconds / 1000;
+        metrics->queueingDelays = queueingDelays;
+        result->append(metrics);
+    }
+    return result;
+}
+
 void Process::sleep(int milliseconds) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    Worker* worker = currentProcess->getWorker();
+    if (worker != nullptr) {
+        worker->sleep(currentProcess, milliseconds);
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
 }
@@ -3,6 +3,7 @@
 
 #include <Runtime.h>
 #include <Message.h>
+#include <ProcessMetrics.h>
 #include <System.h>
 
 class Process: public object {
@@ -12,12 +13,37 @@ public:
         Pointer<MessageHandlerFactory> factory,
         Pointer<string> name);
     static int registerMessageHandler(Pointer<MessageHandler> messageHandler);
-    static void send(int destinationPid, Pointer<Message> message);
+    static int send(int destinationPid, Pointer<Message> message);
+    static int sendBatch(
+        int destinationPid,
+        Pointer<Array<Pointer<Message> > > messages);
+    static void join(Pointer<string> group);
+    static void leave(Pointer<string> group);
+    static int publish(Pointer<string> group, Pointer<Message> message);
+    static bool listen(Pointer<string> socketPath);
+    static int connect(Pointer<string> socketPath, Pointer<string> name);
+    static int getNode();
+    static int sendAfter(
+        int destinationPid,
+        Pointer<Message> message,
+        int milliseconds);
+    static bool cancelTimer(int timerId);
     static Pointer<Message> receive();
+    static Pointer<Message> receive(int timeoutMilliseconds);
+    static Pointer<Array<Pointer<Message> > > receiveAll(int max);
     static Pointer<Message> receiveMethodResult(int messageId);
     static Pointer<Message> receive(int messageType, int messageId);
+    static bool hasMethodResult(int messageId);
+    static bool waitForMethodResult(int messageId, int timeoutMilliseconds);
+    static void setSpawnMailboxLimit(int capacity, int overflowPolicy);
+    static void setSpawnPlacement(int placement, int core);
+    static void setSpawnRegionAllocation(bool enabled);
+    static int getMailboxHighWaterMark(int pid);
+    static int getMailboxLength(int pid);
+    static Pointer<Array<Pointer<ProcessMetrics> > > getMetrics();
     static int getPid();
     static void terminate();
+    static void terminate(int pid);
     static void wait(int pid);
     static void sleep(int milliseconds);
 };
@@ -0,0 +1,53 @@
+import "System"
+
+// A snapshot of the runtime metrics of one process, as returned by
+// Process.getMetrics().
+class ProcessMetrics {
+
+    // PID of the process.
+    int pid
+
+    // Name of the process, or an empty string if the process has no name.
+    string name
+
+    // Number of messages the process has received and sent.
+    long messagesReceived
+    long messagesSent
+
+    // Number of method calls queued in the mailbox of the process, and the
+    // most that have been queued at the same time.
+    int mailboxLength
+    int mailboxHighWaterMark
+
+    // Wall clock time the process has spent handling method calls, in
+    // microseconds.
+    long handlingMicroseconds
+
+    // Histogram of how long messages waited in the mailbox before the process
+    // received them. Element i counts the messages that waited less than 2^i
+    // microseconds, but not less than 2^(i - 1). The last element counts the
+    // messages that waited longer than that.
+    long[] queueingDelays
+
+    // Return the number of microseconds within which the given percent of the
+    // received messages were received after they were sent. The value is the
+    // upper bound of a histogram element, so it is rounded up to a power of
+    // two. Returns 0 if no messages have been received.
+    long getQueueingDelayPercentile(int percent) {
+        var long total = 0
+        queueingDelays.each |count| { total += count }
+        if total == 0 {
+            return 0
+        }
+
+        let long limit = (total * percent + 99) / 100
+        var long seen = 0
+        for var i = 0; i < queueingDelays.length; i++ {
+            seen += queueingDelays[i]
+            if seen >= limit {
+                return 1 << i
+            }
+        }
+        return 1 << queueingDelays.length
+    }
+}
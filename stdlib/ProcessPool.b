@@ -0,0 +1,119 @@
+// A pool of processes of the same process type. The processes are spawned up
+// front and reused, so handing work to a process costs one message instead of
+// spawning and terminating a process.
+//
+// The pool hands out the process with the fewest queued calls. It spawns
+// another process when all processes have at least growThreshold calls
+// queued, and terminates idle processes when there are more idle processes
+// than needed, but it never has fewer than minSize or more than maxSize
+// processes. A process that has terminated, for example because a call to it
+// threw, is dropped from the pool and replaced if the pool would otherwise
+// have fewer than minSize processes.
+//
+// A process handed out by get() should be used right away and not be kept,
+// since the pool may terminate it later.
+class ProcessPool<P> {
+
+    // Create a pool and spawn minSize processes.
+    init(int minSize, int maxSize) {
+        minimumSize = minSize
+        maximumSize = maxSize
+        for var i = 0; i < minSize; i++ {
+            members.append(new P)
+        }
+    }
+
+    // Return the process with the fewest queued calls.
+    P get() {
+        removeTerminated
+
+        var leastLoaded = -1
+        var leastQueued = 0
+        var idle = 0
+        for var i = 0; i < members.length; i++ {
+            let queued = Process.getMailboxLength(members[i].getPid)
+            if queued < 0 {
+                // Terminated since removeTerminated, dropped next time.
+                continue
+            }
+            if queued == 0 {
+                idle++
+            }
+            if leastLoaded == -1 || queued < leastQueued {
+                leastLoaded = i
+                leastQueued = queued
+            }
+        }
+
+        if leastLoaded == -1 ||
+           (leastQueued >= growThreshold && members.length < maximumSize) {
+            let member = new P
+            members.append(member)
+            return member
+        }
+
+        let member = members[leastLoaded]
+        if idle > 1 && members.length > minimumSize {
+            shrink(member)
+        }
+        return member
+    }
+
+    // Return the number of processes in the pool.
+    int size() {
+        return members.length
+    }
+
+    // Terminate all processes in the pool once they have handled their queued
+    // calls, and wait for them to terminate.
+    stop() {
+        members.each |member| {
+            Process.terminate(member.getPid)
+        }
+        members.each |member| {
+            member.wait
+        }
+        members = new P[]
+    }
+
+private:
+    // Number of calls queued for every process in the pool before the pool
+    // spawns another process.
+    static int growThreshold = 2
+
+    var members = new P[]
+    int minimumSize
+    int maximumSize
+
+    // Drop the processes that have terminated, which getMailboxLength tells
+    // by returning -1, and spawn new ones up to the minimum size.
+    removeTerminated() {
+        var alive = new P[members.length]
+        members.each |member| {
+            if Process.getMailboxLength(member.getPid) >= 0 {
+                alive.append(member)
+            }
+        }
+        members = alive
+        while members.length < minimumSize {
+            members.append(new P)
+        }
+    }
+
+    // Terminate one idle process other than the given one.
+    shrink(P keep) {
+        var kept = new P[members.length]
+        var terminated = false
+        members.each |member| {
+            if !terminated &&
+               member.getPid != keep.getPid &&
+               Process.getMailboxLength(member.getPid) == 0 {
+                Process.terminate(member.getPid)
+                terminated = true
+            } else {
+                kept.append(member)
+            }
+        }
+        members = kept
+    }
+}
@@ -1,8 +1,19 @@
 
+import "ByteBuffer"
+
 message interface _Cloneable {
 
     // Clone the object (do a deep copy).
     object _clone()
+
+    // Return true if the object and all objects it references are referenced
+    // exactly once. Such an object can be handed over to another process
+    // without a deep copy.
+    bool _isUnique()
+
+    // Write the object, and all objects it references, to the buffer. The
+    // object is read back by ByteBuffer.readObject().
+    _serialize(ByteBuffer buffer)
 }
 
 int _hash(char self) {
@@ -32,96 +43,28 @@ int _hash(bool self) {
     return 0
 }
 
-message class __string {
-    private var char[] buf
-
-    init(char[] value) {
-        buf = value
-    }
-
-    bool notEquals(string other) {
-        if equals(other) {
-            return false
-        }
-        return true        
-    }
-
-    bool equals(string other) {
-        if buf.length != other.buf.length {
-            return false
-        }
-        let length = buf.length
-        let otherBuf = other.buf
-        for var i = 0; i < length; i++ {
-            if buf[i] != otherBuf[i] {
-                return false
-            }
-        }
-        return true
-    }
-
-    append(string other) {
-        buf.appendAll(other.buf)
-    }
-
-    string concat(string other) {
-        return new string(buf.concat(other.buf))
-    }
-
-    int length() {
-        return buf.length
-    }
+// The built-in string type. It is implemented natively in System.h and
+// System.cpp, so that a short string takes a single allocation.
+message native class __string {
 
-    bool empty() {
-        return buf.length == 0
-    }
+    // Create a string from a copy of the characters.
+    init(char[] value)
 
-    char at(int index) {
-        return buf[index]
-    }
+    bool notEquals(string other)
+    bool equals(string other)
+    append(string other)
+    string concat(string other)
+    int length()
+    bool empty()
+    char at(int index)
 
-    char[] characters() {
-        return buf
-    }
+    // Returns a copy of the characters.
+    char[] characters()
 
     // Creates a new string with leading and trailing space characters removed.
-    string trim() {
-        let length = buf.length
-        var start = 0
-        while start < length {
-            if buf[start] != ' ' {
-                break
-            }
-            start++
-        }
-        var end = length - 1
-        while end > 0 {
-            if buf[end] != ' ' {
-                break
-            }
-            end--            
-        }
-        return new string(buf[start...end])
-    }
+    string trim()
 
     // Splits the string into an array of substrings/tokens. The delimiter is
     // the space character.
-    string[] split() {
-        var result = new string[]
-        let length = buf.length
-        if length == 0 {
-            return result
-        }
-        var tokenStart = 0
-        for var i = 0; i < length; i++ {
-            if buf[i] == ' ' && i > 0 {
-                let tokenChars = buf[tokenStart ... i - 1]
-                result.append(new string(tokenChars))
-                tokenStart = i + 1
-            }
-        }
-        let tokenChars = buf[tokenStart ... length - 1]
-        result.append(new string(tokenChars))
-        return result
-    }
+    string[] split()
 }
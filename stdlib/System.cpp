@@ -0,0 +1,226 @@
+#include "System.h"
+
+#include <string.h>
+
+namespace {
+    // The type tag that the compiler would give the string message class.
+    const int stringTypeTag = 398550328;
+}
+
+int _hash(char self) {
+    return self;
+}
+
+int _hash(unsigned char self) {
+    return self;
+}
+
+int _hash(int self) {
+    return self;
+}
+
+int _hash(long long self) {
+    return static_cast<int>(self);
+}
+
+int _hash(float self) {
+    return static_cast<int>(self);
+}
+
+int _hash(bool self) {
+    return self ? 1 : 0;
+}
+
+string::string(const Pointer<Array<char> >& value) {
+    initialize(value->length());
+    if (len != 0) {
+        memcpy(mutableData(), value->data(), len);
+    }
+}
+
+string::string(const char* chars, int length) {
+    initialize(length);
+    if (len != 0) {
+        memcpy(mutableData(), chars, len);
+    }
+}
+
+string::string(const Pointer<string>& other) {
+    initialize(other->len);
+    if (len != 0) {
+        memcpy(mutableData(), other->data(), len);
+    }
+}
+
+// The characters are serialized as a char array, the way the compiler would
+// serialize a message class with a char array data member.
+string::string(const Pointer<ByteBuffer>& buffer) {
+    Pointer<Array<char> > chars = buffer->readCharArray();
+    initialize(chars->length());
+    if (len != 0) {
+        memcpy(mutableData(), chars->data(), len);
+    }
+}
+
+string::string(
+    const char* first,
+    unsigned firstLength,
+    const char* second,
+    unsigned secondLength) {
+
+    initialize(firstLength + secondLength);
+    char* chars = mutableData();
+    if (firstLength != 0) {
+        memcpy(chars, first, firstLength);
+    }
+    if (secondLength != 0) {
+        memcpy(chars + firstLength, second, secondLength);
+    }
+}
+
+string::string(unsigned capacity) {
+    initialize(capacity);
+    len = 0;
+}
+
+string::~string() {
+    if (!isInline()) {
+        Allocator::deallocate(heapChars, cap);
+    }
+}
+
+Pointer<string> string::withCapacity(unsigned capacity) {
+    return Pointer<string>(new string(capacity));
+}
+
+Pointer<object> string::_clone() {
+    return Pointer<string>(new string(this));
+}
+
+bool string::_isUnique() {
+    return referenceCount == 1;
+}
+
+void string::_serialize(const Pointer<ByteBuffer>& buffer) {
+    buffer->writeInt(stringTypeTag);
+    buffer->writeCharArray(characters());
+}
+
+bool string::notEquals(const Pointer<string>& other) {
+    return !equals(other);
+}
+
+bool string::equals(const Pointer<string>& other) {
+    return len == other->len && memcmp(data(), other->data(), len) == 0;
+}
+
+void string::append(const Pointer<string>& other) {
+    unsigned otherLength = other->len;
+    unsigned combinedLength = len + otherLength;
+    unsigned capacity = isInline() ? inlineCapacity : cap;
+    if (combinedLength > capacity) {
+        grow(combinedLength * 2);
+    }
+    if (otherLength != 0) {
+        // The other string may be this string, in which case its characters
+        // have moved along with ours.
+        memcpy(mutableData() + len, other->data(), otherLength);
+    }
+    len = combinedLength;
+}
+
+Pointer<string> string::concat(const Pointer<string>& other) {
+    return Pointer<string>(new string(data(), len, other->data(), other->len));
+}
+
+int string::length() {
+    return len;
+}
+
+bool string::empty() {
+    return len == 0;
+}
+
+char string::at(int index) {
+    if (static_cast<unsigned>(index) >= len) {
+        throw IndexOutOfBoundsException();
+    }
+    return data()[index];
+}
+
+// The array is a copy, so changing it does not change the string.
+Pointer<Array<char> > string::characters() {
+    char* chars = new char[len];
+    if (len != 0) {
+        memcpy(chars, data(), len);
+    }
+    return Pointer<Array<char> >(new Array<char>(chars, len));
+}
+
+Pointer<string> string::trim() {
+    const char* chars = data();
+    unsigned start = 0;
+    while (start < len && chars[start] == ' ') {
+        start++;
+    }
+    int end = len - 1;
+    while (end > 0 && chars[end] == ' ') {
+        end--;
+    }
+    return substring(start, end);
+}
+
+Pointer<Array<Pointer<string> > > string::split() {
+    Pointer<Array<Pointer<string> > > result(new Array<Pointer<string> >());
+    if (len == 0) {
+        return result;
+    }
+    const char* chars = data();
+    unsigned tokenStart = 0;
+    for (unsigned i = 0; i < len; i++) {
+        if (chars[i] == ' ' && i > 0) {
+            result->append(substring(tokenStart, i - 1));
+            tokenStart = i + 1;
+        }
+    }
+    result->append(substring(tokenStart, len - 1));
+    return result;
+}
+
+void string::initialize(unsigned length) {
+    len = length;
+    if (length <= inlineCapacity) {
+        cap = 0;
+    } else {
+        cap = length;
+        heapChars = static_cast<char*>(Allocator::allocate(length));
+    }
+}
+
+void string::grow(unsigned newCapacity) {
+    char* newChars = static_cast<char*>(Allocator::allocate(newCapacity));
+    if (len != 0) {
+        memcpy(newChars, data(), len);
+    }
+    if (!isInline()) {
+        Allocator::deallocate(heapChars, cap);
+    }
+    heapChars = newChars;
+    cap = newCapacity;
+}
+
+// Same bounds as slicing the characters, begin...end, as an array.
+Pointer<string> string::substring(unsigned begin, unsigned end) {
+    if (begin >= len || end >= len || begin > end) {
+        throw IndexOutOfBoundsException();
+    }
+    return Pointer<string>(new string(data() + begin, end - begin + 1));
+}
+
+static const bool string_registered =
+    ByteBuffer::registerType(
+        stringTypeTag,
+        "string",
+        [] (const Pointer<ByteBuffer>& buffer) -> Pointer<object> {
+            return new string(buffer);
+        });
@@ -0,0 +1,104 @@
+#ifndef System_h
+#define System_h
+
+#include <Runtime.h>
+
+#include "ByteBuffer.h"
+
+class _Cloneable: public virtual object {
+public:
+    virtual ~_Cloneable() {}
+
+    virtual Pointer<object> _clone() = 0;
+    virtual bool _isUnique() = 0;
+    virtual void _serialize(const Pointer<ByteBuffer>& buffer) = 0;
+};
+
+int _hash(char self);
+int _hash(unsigned char self);
+int _hash(int self);
+int _hash(long long self);
+int _hash(float self);
+int _hash(bool self);
+
+// The built-in string type. The characters of a short string are stored
+// inside the string object, so that it takes a single allocation. A longer
+// string keeps its characters in one block from the allocator.
+class string: public virtual object, public _Cloneable {
+public:
+    // Copies the characters of the array.
+    explicit string(const Pointer<Array<char> >& value);
+    string(const char* chars, int length);
+    explicit string(const Pointer<string>& other);
+    explicit string(const Pointer<ByteBuffer>& buffer);
+    ~string();
+
+    virtual Pointer<object> _clone();
+    virtual bool _isUnique();
+    virtual void _serialize(const Pointer<ByteBuffer>& buffer);
+
+    bool notEquals(const Pointer<string>& other);
+    bool equals(const Pointer<string>& other);
+    void append(const Pointer<string>& other);
+    Pointer<string> concat(const Pointer<string>& other);
+    int length();
+    bool empty();
+    char at(int index);
+    Pointer<Array<char> > characters();
+    Pointer<string> trim();
+    Pointer<Array<Pointer<string> > > split();
+
+    // Create an empty string with room for capacity characters. The
+    // characters are written through mutableData(), and then setLength()
+    // tells how many of them were written.
+    static Pointer<string> withCapacity(unsigned capacity);
+
+    // The characters are not null terminated.
+    const char* data() const {
+        return isInline() ? inlineChars : heapChars;
+    }
+
+    char* mutableData() {
+        return isInline() ? inlineChars : heapChars;
+    }
+
+    // The length must not be more than the capacity of the string.
+    void setLength(unsigned length) {
+        len = length;
+    }
+
+private:
+    static const unsigned inlineCapacity = 16;
+
+    string(const string&) = delete;
+    string& operator=(const string&) = delete;
+
+    explicit string(unsigned capacity);
+
+    string(
+        const char* first,
+        unsigned firstLength,
+        const char* second,
+        unsigned secondLength);
+
+    bool isInline() const {
+        return cap == 0;
+    }
+
+    void initialize(unsigned length);
+    void grow(unsigned newCapacity);
+    Pointer<string> substring(unsigned begin, unsigned end);
+
+    unsigned len;
+
+    // The capacity of the heap block, or zero while the characters are stored
+    // inline.
+    unsigned cap;
+
+    union {
+        char inlineChars[inlineCapacity];
+        char* heapChars;
+    };
+};
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef TimerWheel_h
+#define TimerWheel_h
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <Message.h>
+
+namespace ProcessRuntime {
+    // The timer wheel has timerWheelLevelCount levels of timerWheelSlotCount
+    // slots each. One tick of the wheel is one millisecond.
+    const int timerWheelSlotBits = 6;
+    const int timerWheelSlotCount = 1 << timerWheelSlotBits;
+    const int timerWheelSlotMask = timerWheelSlotCount - 1;
+    const int timerWheelLevelCount = 4;
+
+    // Timers that send a message to a process when they expire. A hierarchical
+    // timer wheel keeps the timers, so starting and cancelling a timer takes
+    // constant time no matter how many timers there are. Level 0 has one slot
+    // per tick, and each higher level has one slot per turn of the level
+    // below. When a level has turned once, the timers of the next slot of the
+    // level above are moved down to where they belong. All timers are run by
+    // one thread, which only wakes up when a slot in level 0 has timers or
+    // when it is time to move timers down. The thread hands the message of
+    // each expired timer to the send function the wheel was created with.
+    class TimerWheel {
+    public:
+        using SendFunction =
+            void (*)(int destinationPid, std::unique_ptr<Message> message);
+
+        explicit TimerWheel(SendFunction sendFunction);
+
+        int start(
+            int milliseconds,
+            int destinationPid,
+            std::unique_ptr<Message> message);
+        bool cancel(int timerId);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Timer;
+
+        // A slot is a doubly linked list of timers, so that a timer can be
+        // unlinked without searching the slot.
+        struct Slot {
+            Slot() : head(nullptr) {}
+
+            Timer* head;
+        };
+
+        struct Timer {
+            int id;
+            int64_t expiry;
+            int destinationPid;
+            std::unique_ptr<Message> message;
+            Slot* slot;
+            Timer* prev;
+            Timer* next;
+        };
+
+        void run();
+        void insert(Timer* timer);
+        void unlink(Timer* timer);
+        void expire(int64_t tick, std::vector<Timer*>& expired);
+        void cascade(int level, int64_t tick);
+        int64_t getNextWakeupTick() const;
+        int64_t getTick() const;
+
+        SendFunction send;
+        Slot slots[timerWheelLevelCount][timerWheelSlotCount];
+        std::unordered_map<int, Timer*> timerMap;
+        std::mutex mutex;
+        std::condition_variable condition;
+        Clock::time_point startTime;
+        int64_t currentTick;
+        int timerIdCounter;
+        bool isRunning;
+    };
+
+    inline TimerWheel::TimerWheel(SendFunction sendFunction) :
+        send(sendFunction),
+        slots(),
+        timerMap(),
+        mutex(),
+        condition(),
+        startTime(Clock::now()),
+        currentTick(0),
+        timerIdCounter(0),
+        isRunning(false) {}
+
+    // Start a timer that sends the given message to the given process when it
+    // expires. Returns the ID of the timer.
+    inline int TimerWheel::start(
+        int milliseconds,
+        int destinationPid,
+        std::unique_ptr<Message> message) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!isRunning) {
+            std::thread(&TimerWheel::run, this).detach();
+            isRunning = true;
+        }
+        if (timerMap.empty()) {
+            // The wheel does not turn while there are no timers.
+            currentTick = getTick();
+        }
+
+        Timer* timer = new Timer();
+        timer->id = ++timerIdCounter;
+        timer->expiry = getTick() + (milliseconds > 0 ? milliseconds : 0);
+        timer->destinationPid = destinationPid;
+        timer->message = std::move(message);
+        insert(timer);
+        timerMap[timer->id] = timer;
+
+        condition.notify_one();
+        return timer->id;
+    }
+
+    // Cancel a timer. Returns false if the timer has already expired.
+    inline bool TimerWheel::cancel(int timerId) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto i = timerMap.find(timerId);
+        if (i == timerMap.end()) {
+            return false;
+        }
+        Timer* timer = i->second;
+        timerMap.erase(i);
+        unlink(timer);
+        delete timer;
+        return true;
+    }
+
+    inline void TimerWheel::run() {
+        std::vector<Timer*> expired;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            if (timerMap.empty()) {
+                condition.wait(lock);
+                continue;
+            }
+
+            int64_t nextTick = getNextWakeupTick();
+            int64_t now = getTick();
+            if (nextTick > now) {
+                condition.wait_until(
+                    lock,
+                    startTime + std::chrono::milliseconds(nextTick));
+                continue;
+            }
+
+            while (currentTick <= now) {
+                expire(currentTick, expired);
+                currentTick++;
+            }
+
+            // Send the messages without holding the lock, so that processes can
+            // start and cancel timers in the meantime.
+            lock.unlock();
+            for (Timer* timer: expired) {
+                send(timer->destinationPid, std::move(timer->message));
+                delete timer;
+            }
+            expired.clear();
+            lock.lock();
+        }
+    }
+
+    inline void TimerWheel::insert(Timer* timer) {
+        int64_t expiry =
+            timer->expiry < currentTick ? currentTick : timer->expiry;
+        int64_t delay = expiry - currentTick;
+
+        // Find the lowest level that reaches far enough. Timers that are too
+        // far away for the top level are put there anyway, and are moved down
+        // when the top level comes around to them.
+        int level = 0;
+        while (level < timerWheelLevelCount - 1 &&
+               delay >= (int64_t(1) << (timerWheelSlotBits * (level + 1)))) {
+            level++;
+        }
+
+        int index =
+            (expiry >> (timerWheelSlotBits * level)) & timerWheelSlotMask;
+        Slot& slot = slots[level][index];
+        timer->slot = &slot;
+        timer->prev = nullptr;
+        timer->next = slot.head;
+        if (slot.head != nullptr) {
+            slot.head->prev = timer;
+        }
+        slot.head = timer;
+    }
+
+    inline void TimerWheel::unlink(Timer* timer) {
+        if (timer->next != nullptr) {
+            timer->next->prev = timer->prev;
+        }
+        if (timer->prev != nullptr) {
+            timer->prev->next = timer->next;
+        } else {
+            timer->slot->head = timer->next;
+        }
+    }
+
+    // Move the timers of the slots that are due at the given tick down to the
+    // lower levels, and collect the timers that expire at the given tick.
+    inline void TimerWheel::expire(
+        int64_t tick,
+        std::vector<Timer*>& expired) {
+
+        for (int level = 1; level < timerWheelLevelCount; level++) {
+            int64_t levelTicks = int64_t(1) << (timerWheelSlotBits * level);
+            if ((tick & (levelTicks - 1)) != 0) {
+                break;
+            }
+            cascade(level, tick);
+        }
+
+        Slot& slot = slots[0][tick & timerWheelSlotMask];
+        while (Timer* timer = slot.head) {
+            slot.head = timer->next;
+            timerMap.erase(timer->id);
+            expired.push_back(timer);
+        }
+    }
+
+    inline void TimerWheel::cascade(int level, int64_t tick) {
+        int index =
+            (tick >> (timerWheelSlotBits * level)) & timerWheelSlotMask;
+        Slot& slot = slots[level][index];
+        Timer* timer = slot.head;
+        slot.head = nullptr;
+        while (timer != nullptr) {
+            Timer* next = timer->next;
+            insert(timer);
+            timer = next;
+        }
+    }
+
+    // Return the tick when the thread must wake up next: the first slot with
+    // timers in what is left of the current turn of level 0, or the end of the
+    // turn.
+    inline int64_t TimerWheel::getNextWakeupTick() const {
+        int64_t endOfTurn = (currentTick | timerWheelSlotMask) + 1;
+        for (int64_t tick = currentTick; tick < endOfTurn; tick++) {
+            if (slots[0][tick & timerWheelSlotMask].head != nullptr) {
+                return tick;
+            }
+        }
+        return endOfTurn;
+    }
+
+    inline int64_t TimerWheel::getTick() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - startTime).count();
+    }
+}
+
+#endif
@@ -0,0 +1,285 @@
+#ifndef Tracer_h
+#define Tracer_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ProcessRuntime {
+    // Number of events each thread keeps when tracing, unless overridden by
+    // BUHRLANG_TRACE_EVENTS. When a buffer is full the oldest events are
+    // overwritten.
+    const size_t defaultTraceBufferCapacity = 16 * 1024;
+
+    // Kinds of events recorded by the tracer.
+    enum TraceEventKind {
+        TraceSpawn,
+        TraceSend,
+        TraceDequeue,
+        TraceHandleBegin,
+        TraceHandleEnd,
+        TraceTerminate
+    };
+
+    struct TraceEvent {
+        long long time;
+        int pid;
+        int otherPid;
+        int messageId;
+        int messageType;
+        int interfaceId;
+        int kind;
+    };
+
+    // The events recorded by one thread. Only the owning thread writes to the
+    // buffer, so recording an event takes no lock.
+    class TraceBuffer {
+    public:
+        explicit TraceBuffer(size_t capacity) : events(capacity), count(0) {}
+
+        void record(const TraceEvent& event) {
+            size_t index = count.load(std::memory_order_relaxed);
+            events[index % events.size()] = event;
+            count.store(index + 1, std::memory_order_release);
+        }
+
+        template<typename F>
+        void forEach(F function) const {
+            size_t end = count.load(std::memory_order_acquire);
+            size_t begin = end > events.size() ? end - events.size() : 0;
+            for (size_t i = begin; i < end; i++) {
+                function(events[i % events.size()]);
+            }
+        }
+
+    private:
+        std::vector<TraceEvent> events;
+        std::atomic<size_t> count;
+    };
+
+    // Records the flow of messages between processes when the environment
+    // variable BUHRLANG_TRACE names a file. The events are written to that
+    // file in the Chrome trace event format when the program exits, and can
+    // be viewed in chrome://tracing or Perfetto. Each process is shown as a
+    // thread, and each message as an arrow from the sender to the receiver.
+    class Tracer {
+    public:
+        Tracer();
+
+        bool isEnabled() const {
+            return enabled;
+        }
+
+        void recordSpawn(int parentPid, int pid, const std::string& name);
+        void record(
+            int kind,
+            int pid,
+            int otherPid,
+            int messageType,
+            int messageId,
+            int interfaceId);
+        void flush();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        TraceBuffer* getBuffer();
+        void writeEvent(FILE* file, const TraceEvent& event, bool& first);
+
+        bool enabled;
+        std::string fileName;
+        size_t bufferCapacity;
+        Clock::time_point startTime;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<TraceBuffer>> buffers;
+        std::map<int, std::string> processNames;
+    };
+
+    inline Tracer::Tracer() :
+        enabled(false),
+        fileName(),
+        bufferCapacity(defaultTraceBufferCapacity),
+        startTime(Clock::now()),
+        mutex(),
+        buffers(),
+        processNames() {
+
+        const char* traceFile = getenv("BUHRLANG_TRACE");
+        if (traceFile != nullptr && *traceFile != '\0') {
+            enabled = true;
+            fileName = traceFile;
+            processNames[-1] = "runtime";
+            processNames[0] = "root";
+        }
+        const char* eventsStr = getenv("BUHRLANG_TRACE_EVENTS");
+        if (eventsStr != nullptr && atoi(eventsStr) > 0) {
+            bufferCapacity = atoi(eventsStr);
+        }
+    }
+
+    inline void Tracer::recordSpawn(
+        int parentPid,
+        int pid,
+        const std::string& name) {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            processNames[pid] =
+                name.empty() ? "process " + std::to_string(pid) : name;
+        }
+        record(TraceSpawn, parentPid, pid, 0, 0, 0);
+    }
+
+    inline void Tracer::record(
+        int kind,
+        int pid,
+        int otherPid,
+        int messageType,
+        int messageId,
+        int interfaceId) {
+
+        TraceEvent event;
+        event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - startTime).count();
+        event.pid = pid;
+        event.otherPid = otherPid;
+        event.messageType = messageType;
+        event.messageId = messageId;
+        event.interfaceId = interfaceId;
+        event.kind = kind;
+        getBuffer()->record(event);
+    }
+
+    inline TraceBuffer* Tracer::getBuffer() {
+        static thread_local TraceBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            // The buffer outlives the thread, so that the events of terminated
+            // processes are written as well.
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(
+                std::unique_ptr<TraceBuffer>(new TraceBuffer(bufferCapacity)));
+            buffer = buffers.back().get();
+        }
+        return buffer;
+    }
+
+    // Write the recorded events to the trace file. Events that are recorded by
+    // processes that are still running while this happens may be missing.
+    inline void Tracer::flush() {
+        if (!enabled) {
+            return;
+        }
+        FILE* file = fopen(fileName.c_str(), "w");
+        if (file == nullptr) {
+            fprintf(stderr, "Could not open trace file %s\n", fileName.c_str());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        for (const auto& entry: processNames) {
+            fprintf(file,
+                    "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    "\"tid\":%d,\"args\":{\"name\":\"",
+                    first ? "" : ",\n",
+                    entry.first);
+            for (char c: entry.second) {
+                if (c == '"' || c == '\\') {
+                    fprintf(file, "\\%c", c);
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    fprintf(file, "\\u%04x", c);
+                } else {
+                    fputc(c, file);
+                }
+            }
+            fprintf(file, "\"}}");
+            first = false;
+        }
+        for (const auto& buffer: buffers) {
+            buffer->forEach([&](const TraceEvent& event) {
+                writeEvent(file, event, first);
+            });
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+    }
+
+    inline void Tracer::writeEvent(
+        FILE* file,
+        const TraceEvent& event,
+        bool& first) {
+
+        // A message ID is only unique among messages of the same type, since a
+        // method result carries the ID of the method call.
+        long long flowId = (static_cast<long long>(event.messageId) << 4) |
+                           event.messageType;
+        double timestamp = event.time / 1000.0;
+        const char* separator = first ? "" : ",\n";
+        first = false;
+
+        switch (event.kind) {
+            case TraceSpawn:
+                fprintf(file,
+                        "%s{\"name\":\"spawn\",\"ph\":\"i\",\"s\":\"t\","
+                        "\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                        "\"args\":{\"child\":%d}}",
+                        separator,
+                        event.pid,
+                        timestamp,
+                        event.otherPid);
+                break;
+            case TraceSend:
+            case TraceDequeue:
+                // Sends and dequeues are zero length slices, tied together by a
+                // flow arrow.
+                fprintf(file,
+                        "%s{\"name\":\"%s\",\"cat\":\"message\",\"ph\":\"X\","
+                        "\"dur\":0,\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                        "\"bind_id\":\"0x%llx\",\"%s\":true,"
+                        "\"args\":{\"%s\":%d,\"type\":%d,\"id\":%d,"
+                        "\"interfaceId\":%d}}",
+                        separator,
+                        event.kind == TraceSend ? "send" : "dequeue",
+                        event.pid,
+                        timestamp,
+                        flowId,
+                        event.kind == TraceSend ? "flow_out" : "flow_in",
+                        event.kind == TraceSend ? "to" : "pid",
+                        event.kind == TraceSend ? event.otherPid : event.pid,
+                        event.messageType,
+                        event.messageId,
+                        event.interfaceId);
+                break;
+            case TraceHandleBegin:
+            case TraceHandleEnd:
+                fprintf(file,
+                        "%s{\"name\":\"handleMessage\",\"ph\":\"%s\","
+                        "\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                        "\"args\":{\"id\":%d,\"interfaceId\":%d}}",
+                        separator,
+                        event.kind == TraceHandleBegin ? "B" : "E",
+                        event.pid,
+                        timestamp,
+                        event.messageId,
+                        event.interfaceId);
+                break;
+            case TraceTerminate:
+                fprintf(file,
+                        "%s{\"name\":\"terminate\",\"ph\":\"i\",\"s\":\"t\","
+                        "\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+                        separator,
+                        event.pid,
+                        timestamp);
+                break;
+        }
+    }
+}
+
+#endif
@@ -7,17 +7,7 @@
 
 namespace Utils {
     inline Pointer<string> makeString(const char* buf, size_t length) {
-        char* chars = new char[length];
-        memcpy(chars, buf, length);
-        Pointer<Array<char> > charArrayPtr(new Array<char>(chars, length));
-        Pointer<string> str(new string(charArrayPtr));
-        return str;
-    }
-
-    inline Pointer<string> makeStringNoCopy(char* buf, size_t length) {
-        Pointer<Array<char> > charArrayPtr(new Array<char>(buf, length));
-        Pointer<string> str(new string(charArrayPtr));
-        return str;
+        return Pointer<string>(new string(buf, length));
     }
 }
 
@@ -6,6 +6,7 @@ import "List"
 import "Vector"
 import "Map"
 import "Console"
+import "ProcessPool"
 
 // ----------------------------------------------------------------------------
 // Examples:
@@ -2273,6 +2274,182 @@ class EnumTest {
 
 // ----------------------------------------------------------------------------
 
+class EscapeCounter {
+    var int count = 0
+
+    increment() {
+        count++
+    }
+
+    incrementTwice() {
+        increment
+        this.increment
+    }
+
+    int get() {
+        return count
+    }
+
+    int add(int amount) {
+        count += amount
+        return count
+    }
+
+    EscapeCounter self() {
+        return this
+    }
+}
+
+class EscapeAnalysisTest {
+    var EscapeCounter storedCounter
+    var Vector<EscapeCounter> counters = new Vector<EscapeCounter>
+
+    run() {
+        println("----------[Escape Analysis Test]----------")
+
+        // Only data members and methods of the object are used, so it is
+        // allocated on the stack.
+        let local = new EscapeCounter
+        local.increment
+        local.incrementTwice
+        local.count = local.count + 10
+        println(local.get)
+
+        // The objects below outlive the method that creates them, or may, so
+        // they stay on the heap.
+        let returned = makeCounter
+        returned.increment
+        println(returned.get)
+
+        storeCounter
+        storedCounter.increment
+        println(storedCounter.get)
+
+        passCounter
+        counters.at(0).increment
+        println(counters.at(0).get)
+
+        let closure = captureCounter
+        println(closure(5))
+        println(closure(5))
+
+        // The object is used as a value inside one of its methods.
+        let usedAsValue = new EscapeCounter
+        storedCounter = usedAsValue.self
+        usedAsValue.increment
+        println(storedCounter.get)
+    }
+
+    EscapeCounter makeCounter() {
+        let counter = new EscapeCounter
+        counter.increment
+        return counter
+    }
+
+    storeCounter() {
+        let counter = new EscapeCounter
+        counter.incrementTwice
+        storedCounter = counter
+    }
+
+    passCounter() {
+        let counter = new EscapeCounter
+        counter.increment
+        counters.add(counter)
+    }
+
+    fun int(int) captureCounter() {
+        let counter = new EscapeCounter
+        return |int x| { counter.add(x) }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+// Every method but inBounds runs past the end of an array in a way that the
+// range analysis must not take for a counted loop, so the bounds check stays
+// and the process ends with an IndexOutOfBoundsException.
+process BoundsCheckProcess {
+    lessOrEqualBound() {
+        let numbers = [1, 2, 3]
+        var int sum = 0
+        for var i = 0; i <= numbers.length; i++ {
+            sum += numbers[i]
+        }
+        println("Not reached: i <= length")
+    }
+
+    boundOfOtherArray() {
+        let numbers = [1, 2, 3]
+        let longer = [1, 2, 3, 4]
+        var int sum = 0
+        for var i = 0; i < longer.length; i++ {
+            sum += numbers[i]
+        }
+        println("Not reached: bound of another array")
+    }
+
+    arrayReassigned() {
+        var numbers = [1, 2, 3]
+        var int sum = 0
+        for var i = 0; i < numbers.length; i++ {
+            if i == 1 {
+                numbers = [1]
+            }
+            sum += numbers[i]
+        }
+        println("Not reached: array reassigned")
+    }
+
+    indexChanged() {
+        let numbers = [1, 2, 3]
+        var int sum = 0
+        for var i = 0; i < numbers.length; i++ {
+            i += 1
+            sum += numbers[i]
+        }
+        println("Not reached: index changed")
+    }
+
+    inBounds() {
+        let numbers = [1, 2, 3]
+        var int sum = 0
+        for var i = 0; i < numbers.length; i++ {
+            sum += numbers[i]
+        }
+        println(sum)
+        Process.terminate
+    }
+}
+
+class RangeAnalysisTest {
+    run() {
+        println("----------[Range Analysis Test]----------")
+
+        let lessOrEqual = new BoundsCheckProcess
+        lessOrEqual.lessOrEqualBound
+        lessOrEqual.wait
+
+        let otherArray = new BoundsCheckProcess
+        otherArray.boundOfOtherArray
+        otherArray.wait
+
+        let reassigned = new BoundsCheckProcess
+        reassigned.arrayReassigned
+        reassigned.wait
+
+        let indexChanged = new BoundsCheckProcess
+        indexChanged.indexChanged
+        indexChanged.wait
+
+        let inBounds = new BoundsCheckProcess
+        inBounds.inBounds
+        inBounds.wait
+    }
+}
+
+// ----------------------------------------------------------------------------
+
 class IoTest {
     run() {
         println("----------[I/O Test]----------")
@@ -2496,6 +2673,190 @@ process DbProcess {
 
 // ------------------------------------
 
+process SquaringServer {
+    int square(int n) {
+        return n * n
+    }
+
+    string describe(int n) {
+        // A call to the own process completes at once.
+        let future = squareAsync(n)
+        return Convert.toStr(n) + " squared is " + Convert.toStr(future.await)
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+// ------------------------------------
+
+process BusyServer {
+    var int handled = 0
+
+    handle(int n) {
+        handled++
+    }
+
+    slowHandle(int n) {
+        Process.sleep(20)
+        handled++
+    }
+
+    int getHandled() {
+        return handled
+    }
+
+    int getMailboxHighWaterMark() {
+        return Process.getMailboxHighWaterMark(Process.getPid)
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+// ------------------------------------
+
+process WordServer {
+    var remembered = new string[]
+
+    int countWords(string text) {
+        return text.split.length
+    }
+
+    remember(string text) {
+        let words = text.split
+        remembered.append(words[0] + "-" + Convert.toStr(words.length))
+    }
+
+    string getRemembered() {
+        var result = ""
+        remembered.each |word| {
+            result += word + " "
+        }
+        return result
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+// ------------------------------------
+
+process TimerServer {
+    int slowSquare(int n) {
+        Process.sleep(50)
+        return n * n
+    }
+
+    bool receiveTimesOut() {
+        // Nothing but this call has been sent to this process.
+        return Process.receive(10).type == MessageType.Timeout
+    }
+
+    int receiveDelayed() {
+        let cancelledTimer =
+            Process.sendAfter(Process.getPid,
+                              new Message(100, new Box<int>(1)),
+                              10000)
+        Process.cancelTimer(cancelledTimer)
+        Process.sendAfter(Process.getPid,
+                          new Message(100, new Box<int>(2)),
+                          5)
+        let msg = Process.receive(10000)
+        match msg.data {
+            Box<int> box -> return box.value,
+            _ -> return 0
+        }
+        return 0
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+// ------------------------------------
+
+process BatchServer {
+    int sumBatch(int count) {
+        var messages = new Message[count]
+        for var i = 1; i <= count; i++ {
+            messages.append(new Message(100, new Box<int>(i)))
+        }
+        let sent = Process.sendBatch(Process.getPid, messages)
+
+        var sum = 0
+        var received = 0
+        while received < sent {
+            Process.receiveAll(count).each |msg| {
+                match msg.data {
+                    Box<int> box -> sum += box.value,
+                    _ -> {}
+                }
+                received++
+            }
+        }
+        return sum
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+// ------------------------------------
+
+message class NewsCounter {
+    var int count
+}
+
+process Subscriber {
+    // Return a value so that callers wait until the process has joined.
+    bool subscribe(string group) {
+        Process.join(group)
+        return true
+    }
+
+    bool unsubscribe(string group) {
+        Process.leave(group)
+        return true
+    }
+
+    int receiveNews() {
+        let msg = Process.receive
+        match msg.data {
+            Box<int> box -> return box.value,
+            _ -> return 0
+        }
+        return 0
+    }
+
+    // Changes the counter it receives, which must be its own copy. Other
+    // news is skipped.
+    int receiveAndCount() {
+        while true {
+            let msg = Process.receive
+            match msg.data {
+                NewsCounter counter -> {
+                    counter.count++
+                    return counter.count
+                },
+                _ -> {}
+            }
+        }
+        return 0
+    }
+
+    stop() {
+        Process.terminate
+    }
+}
+
+// ------------------------------------
+
 class CoreProcessTest {
     performanceTest() {
         println("Performance test start.")
@@ -2546,6 +2907,207 @@ class CoreProcessTest {
         client.wait
     }
 
+    futureTest() {
+        var servers = new SquaringServer[]
+        let futures = new FutureGroup<int>
+        for var i = 1; i <= 4; i++ {
+            let server = new SquaringServer
+            futures.add(server.squareAsync(i))
+            servers.append(server)
+        }
+        var sum = 0
+        futures.whenAll.each |square| { sum += square }
+        println("Sum of squares: " + Convert.toStr(sum))
+
+        let description = servers[0].describeAsync(5)
+        while !description.poll {
+            Process.sleep(1)
+        }
+        println(description.await)
+        println(description.await)
+
+        servers.each |server| {
+            server.stop
+            server.wait
+        }
+    }
+
+    // Replies that nobody waits for, and other messages that have been put
+    // aside while looking for a reply, are received in the order they arrived.
+    putAsideOrderTest() {
+        // Let replies left over from the earlier tests arrive, and drop them.
+        while Process.receive(50).type != MessageType.Timeout {}
+
+        let self = Process.getPid
+        [5, 3, 8, 1].each |id| {
+            let reply = new Message(MessageType.MethodResult, new Box<int>(id))
+            reply.id = id
+            Process.send(self, reply)
+            if id == 3 {
+                Process.send(self, new Message(100, new Box<int>(id)))
+            }
+        }
+        println(Process.hasMethodResult(99))
+        var order = ""
+        for var i = 0; i < 5; i++ {
+            let msg = Process.receive
+            order += Convert.toStr(msg.type) + ":" + Convert.toStr(msg.id) + " "
+        }
+        println("Put aside order: " + order)
+    }
+
+    processPoolTest() {
+        let pool = new ProcessPool<SquaringServer>(2, 4)
+        var sum = 0
+        for var i = 1; i <= 10; i++ {
+            sum += pool.get.square(i)
+        }
+        println("Sum of squares from pool: " + Convert.toStr(sum))
+        println(pool.size >= 2 && pool.size <= 4)
+        pool.stop
+        println(pool.size)
+
+        // A process that has terminated is not handed out again.
+        let smallPool = new ProcessPool<SquaringServer>(2, 2)
+        let dead = smallPool.get
+        dead.stop
+        dead.wait
+        let next = smallPool.get
+        println(next.getPid != dead.getPid)
+        println("Square from pool after termination: " +
+                Convert.toStr(next.square(3)))
+        println(smallPool.size)
+        smallPool.stop
+    }
+
+    timerTest() {
+        let server = new TimerServer
+        println(server.receiveTimesOut)
+        println("Delayed message: " + Convert.toStr(server.receiveDelayed))
+
+        let future = server.slowSquareAsync(3)
+        println(future.poll(1))
+        println(future.poll(10000))
+        println(future.await)
+        server.stop
+        server.wait
+    }
+
+    metricsTest() {
+        let server = new SquaringServer
+        for var i = 1; i <= 3; i++ {
+            server.square(i)
+        }
+        Process.getMetrics.each |metrics| {
+            if metrics.pid == server.getPid {
+                println("Messages received: " +
+                        Convert.toStr(metrics.messagesReceived))
+                println(metrics.getQueueingDelayPercentile(100) > 0)
+            }
+        }
+        server.stop
+        server.wait
+    }
+
+    batchTest() {
+        let server = new BatchServer
+        println("Sum of batch: " + Convert.toStr(server.sumBatch(10)))
+        server.stop
+        server.wait
+    }
+
+    publishTest() {
+        var subscribers = new Subscriber[]
+        let news = new FutureGroup<int>
+        for var i = 0; i < 3; i++ {
+            let subscriber = new Subscriber
+            subscriber.subscribe("news")
+            news.add(subscriber.receiveNewsAsync)
+            subscribers.append(subscriber)
+        }
+        let receivers =
+            Process.publish("news", new Message(100, new Box<int>(7)))
+        var sum = 0
+        news.whenAll.each |value| { sum += value }
+        println("Published to " + Convert.toStr(receivers) + ", sum " +
+                Convert.toStr(sum))
+
+        subscribers[0].unsubscribe("news")
+        println(Process.publish("news", new Message(100, new Box<int>(1))))
+
+        // Every receiver gets its own copy of the data.
+        let counts = new FutureGroup<int>
+        for var i = 1; i < 3; i++ {
+            counts.add(subscribers[i].receiveAndCountAsync)
+        }
+        println(Process.publish("news", new Message(100, new NewsCounter)))
+        var countSum = 0
+        counts.whenAll.each |value| { countSum += value }
+        println("Counts after publish: " + Convert.toStr(countSum))
+        subscribers.each |subscriber| {
+            subscriber.stop
+            subscriber.wait
+        }
+    }
+
+    placementTest() {
+        var sum = 0
+        let placements = [ProcessPlacement.Pinned,
+                          ProcessPlacement.NearParent,
+                          ProcessPlacement.Spread,
+                          ProcessPlacement.WithParent,
+                          ProcessPlacement.Default]
+        placements.each |placement| {
+            Process.setSpawnPlacement(placement, 0)
+            let server = new SquaringServer
+            sum += server.square(placement)
+            server.stop
+            server.wait
+        }
+        println("Sum of placed squares: " + Convert.toStr(sum))
+    }
+
+    mailboxLimitTest() {
+        Process.setSpawnMailboxLimit(10, MailboxOverflow.Block)
+        let server = new BusyServer
+        Process.setSpawnMailboxLimit(0, MailboxOverflow.Block)
+        for var i = 0; i < 1000; i++ {
+            server.handle(i)
+        }
+        println("Handled calls: " + Convert.toStr(server.getHandled))
+        println(server.getMailboxHighWaterMark <= 10)
+        server.stop
+        server.wait
+
+        // Calls that the server has taken from its mailbox but not yet
+        // handled still count as queued.
+        let slowServer = new BusyServer
+        for var i = 0; i < 20; i++ {
+            slowServer.slowHandle(i)
+        }
+        Process.sleep(30)
+        println(Process.getMailboxLength(slowServer.getPid) >= 10)
+        slowServer.stop
+        slowServer.wait
+    }
+
+    regionAllocationTest() {
+        Process.setSpawnRegionAllocation(true)
+        let server = new WordServer
+        Process.setSpawnRegionAllocation(false)
+        var words = 0
+        for var i = 0; i < 1000; i++ {
+            words += server.countWords("a region per call " + Convert.toStr(i))
+            if i % 250 == 0 {
+                server.remember("kept word " + Convert.toStr(i))
+            }
+        }
+        println("Counted words: " + Convert.toStr(words))
+        println("Remembered: " + server.getRemembered)
+        server.stop
+        server.wait
+    }
+
     testMessageClass() {
         let query = new Query(5, "table1")
         query.conditions.append(new DbCondition("table1.column2 == 3"))
@@ -2561,6 +3123,16 @@ class CoreProcessTest {
         asynchronousProcessCallTest1
         asynchronousProcessCallTest2
         asynchronousProcessCallTest3
+        futureTest
+        putAsideOrderTest
+        processPoolTest
+        timerTest
+        metricsTest
+        batchTest
+        publishTest
+        placementTest
+        mailboxLimitTest
+        regionAllocationTest
         testMessageClass
         performanceTest
     }
@@ -3340,6 +3912,65 @@ testMessageEnum() {
     }
 }
 
+// ----------------------------------------------------------------------------
+//
+// Test 7. Serializing message classes and message enums to a byte buffer and
+// reading them back.
+//
+// ----------------------------------------------------------------------------
+
+message class Envelope(int sequence): QueryBase(3) {
+    var string sender = "test"
+    var long timestamp = 0
+    var float weight = 0.0
+    var bool urgent = false
+    var int[] codes = new int[]
+    var DbMsg[] messages = new DbMsg[]
+    var DbResult result = DbResult.Error
+}
+
+testSerialization() {
+    let envelope = new Envelope(42)
+    envelope.timestamp = 1234567890
+    envelope.timestamp *= 1000
+    envelope.weight = 0.5
+    envelope.urgent = true
+    envelope.codes.append(3)
+    envelope.codes.append(4)
+    envelope.messages.append(DbMsg.Create(5, "data", DbResult.Ok))
+    envelope.messages.append(DbMsg.Read(6))
+    envelope.result = DbResult.Ok
+
+    let buffer = new ByteBuffer
+    envelope._serialize(buffer)
+    let reader = new ByteBuffer(buffer.toBytes)
+    match reader.readObject {
+        Envelope e -> {
+            println("Envelope " + Convert.toStr(e.sequence) + " from " +
+                    e.sender + ", protocol " + Convert.toStr(e.protocol))
+            println(e.timestamp)
+            println(e.weight)
+            println(e.urgent)
+            println(e.codes[0] + e.codes[1])
+            e.messages.each |msg| {
+                match msg {
+                    DbMsg.Create(key, data, result) ->
+                        println("Create, key: " + Convert.toStr(key) +
+                                " data: " + data),
+                    DbMsg.Read(key) ->
+                        println("Read, key: " + Convert.toStr(key))
+                }
+            }
+            match e.result {
+                DbResult.Ok -> println("Ok"),
+                DbResult.Error -> println("Error")
+            }
+        },
+        _ -> println("Not an envelope")
+    }
+    println(reader.atEnd)
+}
+
 // ----------------------------------------------------------------------------
 
 class StdlibProcessTest {
@@ -3352,6 +3983,7 @@ class StdlibProcessTest {
         test4
         testMessageClass
         testMessageEnum
+        testSerialization
 
         println("done")
     }
@@ -3436,6 +4068,9 @@ main() {
     let enumTest = new EnumTest
     enumTest.run
 
+    let escapeAnalysisTest = new EscapeAnalysisTest
+    escapeAnalysisTest.run
+
     let coreProcessTest = new CoreProcessTest
     coreProcessTest.run
 
@@ -3453,5 +4088,10 @@ main() {
 
     let stdlibProcessTest = new StdlibProcessTest
     stdlibProcessTest.run
+
+    // Runs last, since the processes it spawns would change the pids that the
+    // tests above print.
+    let rangeAnalysisTest = new RangeAnalysisTest
+    rangeAnalysisTest.run
 }
 